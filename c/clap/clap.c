@@ -200,18 +200,29 @@ int clap_parse(
             if (option_index != -1) {
                 values[option_index].enabled = CLAP_ENABLED;
                 if (options[option_index].value_required == CLAP_NO_VALUE) {
-                    if ((arg.type & WITH_VALUE) != 0) {
-                        do {
-                            int option_index;
-                            arg.label++;
-                            arg.value++;
-                            option_index = clap_find_option(
-                                    number_of_options, options, arg);
-                            if (option_index != -1) {
-
+                    if ((arg.type & LETTER) != 0
+                            && (arg.type & WITH_VALUE) != 0) {
+                        /* Grouped letters: -abc | -abVALUE */
+                        const char* letter;
+                        for (letter = arg.value; *letter != 0; ++letter) {
+                            int grouped_index = clap_find_letter_option(
+                                    number_of_options, options, *letter);
+                            if (grouped_index == -1) {
+                                continue;
+                            }
+                            values[grouped_index].enabled = CLAP_ENABLED;
+                            if (options[grouped_index].value_required
+                                    != CLAP_NO_VALUE) {
+                                if (letter[1] != 0) {
+                                    values[grouped_index].string = letter + 1;
+                                }
+                                else if (options[grouped_index].value_required
+                                        == CLAP_VALUE_REQUIRED) {
+                                    result = 1;
+                                }
+                                break;
                             }
                         }
-                        while (arg.label != NULL);
                     }
                 }
                 else{
@@ -219,8 +230,11 @@ int clap_parse(
                         values[option_index].string = arg.value;
                     }
                     else {
-                        struct clap_arg next_arg = clap_match_arg(argv[i+1]);
-                        if (next_arg.type & FREE) {
+                        struct clap_arg next_arg = clap_arg_separator;
+                        if (i + 1 < argc) {
+                            next_arg = clap_match_arg(argv[i + 1]);
+                        }
+                        if (next_arg.type == FREE) {
                             values[option_index].string = argv[++i];
                         }
                         else if (options[option_index].value_required
@@ -244,6 +258,8 @@ int clap_parse(
         *(free_args++) = i;  
     }
 
+    *free_args = -1;
+
     return result;
 }
 
@@ -262,16 +278,17 @@ int clap_print_help(
     int column;
 
     fprintf(output, "Usage: %s [options]", program_name);
-    if (free_args != NULL) {
+    if (free_args != NULL && number_of_free_args > 0) {
         for (i = 0; i < number_of_free_args - 1; ++i) {
             fprintf(output, " %s", free_args[i]);
         }
         
-        if (free_args[i] == free_args[i + 1]) {
+        if (free_args[i] == NULL
+                || (i > 0 && free_args[i] == free_args[i - 1])) {
             fprintf(output, "...\n");
         }
         else {
-            fprintf(output, " %s\n", free_args[i + 1]);
+            fprintf(output, " %s\n", free_args[i]);
         }
     }
     else {
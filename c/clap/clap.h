@@ -100,8 +100,9 @@ int clap_parse(
  * @program_name: program_name to describe
  * @number_of_free_args: size of array of free arguments name
  * @free_args: free arguments names to put in help string
- *             if last two consequent pointer equals produced help will contain
- *             recurrent string of arg in form of "arg_name..."
+ *             if last two consequent pointer equals or last pointer is null
+ *             produced help will contain recurrent string of arg
+ *             in form of "arg_name..."
  * @number_of_options: indicates number of options to parse and as result
  *                     length of options
  * @options: pointer to array of length number_of_options containing
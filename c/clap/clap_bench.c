@@ -0,0 +1,116 @@
+#if !defined(CLAP_BENCH_TRAINING)
+#include "nanotest_bench.h"
+#endif
+#include "clap.h"
+
+#define LENGTH(array) (sizeof(array) / sizeof(0[array]))
+
+static const struct clap_option options[] = {
+    { 'h', "help", CLAP_NO_VALUE, "prints help" },
+    { 'v', "verbose", CLAP_NO_VALUE, "prints more" },
+    { 'q', "quiet", CLAP_NO_VALUE, "prints less" },
+    { 'o', "output", CLAP_VALUE_REQUIRED, "output file" },
+    { 'j', "jobs", CLAP_VALUE_REQUIRED, "number of jobs" },
+    { 'c', "config", CLAP_VALUE_OPTIONAL, "configuration file" },
+    { 0, "color", CLAP_VALUE_OPTIONAL, "colorize output" },
+    { 0, "dry-run", CLAP_NO_VALUE, "does nothing" },
+    { 0, "log-level", CLAP_VALUE_REQUIRED, "verbosity of log" },
+    { 0, "timeout", CLAP_VALUE_REQUIRED, "seconds to wait" },
+    { 'I', "include", CLAP_VALUE_REQUIRED, "include directory" },
+    { 'D', "define", CLAP_VALUE_REQUIRED, "macro definition" }
+};
+
+/* Result is stored to keep calls from being optimised out */
+static volatile int clap_bench_sink;
+
+static void clap_bench_parse(int argc, const char* argv[]) {
+    struct clap_value values[LENGTH(options)];
+    int free_args[64];
+
+    clap_bench_sink += clap_parse(
+        argc,
+        argv,
+        LENGTH(options),
+        options,
+        values,
+        free_args);
+    clap_bench_sink += free_args[0];
+    if (values[LENGTH(options) - 1].enabled) {
+        clap_bench_sink++;
+    }
+}
+
+/* Invocation of a typical tool mixing all supported formats */
+static void clap_parse_typical(void) {
+    static const char* argv[] = {
+        "tool",
+        "-v",
+        "-ooutput.txt",
+        "-j", "8",
+        "--color=always",
+        "--dry-run",
+        "--log-level", "debug",
+        "-I/usr/include",
+        "-DNDEBUG",
+        "input.txt"
+    };
+
+    clap_bench_parse(LENGTH(argv), argv);
+}
+
+/* Word options are looked up by comparing every known word */
+static void clap_parse_words(void) {
+    static const char* argv[] = {
+        "tool",
+        "--define=A", "--define=B", "--include=a", "--include=b",
+        "--timeout=1", "--log-level=info", "--dry-run", "--color",
+        "--config=x", "--jobs=2", "--output=y", "--quiet"
+    };
+
+    clap_bench_parse(LENGTH(argv), argv);
+}
+
+/* Globbed file list passed by a shell */
+static void clap_parse_free_args(void) {
+    static const char* argv[] = {
+        "tool",
+        "a.c", "b.c", "c.c", "d.c", "e.c", "f.c", "g.c", "h.c",
+        "i.c", "j.c", "k.c", "l.c", "m.c", "n.c", "o.c", "p.c",
+        "--",
+        "-a.c", "-b.c", "-c.c", "-d.c", "-e.c", "-f.c", "-g.c", "-h.c"
+    };
+
+    clap_bench_parse(LENGTH(argv), argv);
+}
+
+#if defined(CLAP_BENCH_TRAINING)
+
+/*
+ * Training driver of profile-guided optimisation runs the same workload
+ * CLAP_BENCH_TRAINING times, it can not use nanotest_bench linking clap
+ */
+int main(void) {
+    long i;
+
+    for (i = 0; i < CLAP_BENCH_TRAINING; ++i) {
+        clap_parse_typical();
+        clap_parse_words();
+        clap_parse_free_args();
+    }
+
+    return 0;
+}
+
+#else /* CLAP_BENCH_TRAINING */
+
+int main(int argc, char* argv[]) {
+    static const struct nanotest_bench benches[] = {
+        nanotest_bench(clap_parse_typical),
+        nanotest_bench(clap_parse_words),
+        nanotest_bench(clap_parse_free_args)
+    };
+
+    return nanotest_bench_main(argc, argv, LENGTH(benches), benches);
+}
+
+#endif /* CLAP_BENCH_TRAINING */
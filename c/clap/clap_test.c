@@ -1,4 +1,5 @@
-#include "nanotest.h"
+#include "nanotest_runner.h"
+#include "nanotest_account.h"
 #include "clap.h"
 
 #include <string.h>
@@ -15,7 +16,7 @@ static const struct clap_option options[] = {
 
 #define NUMBER_OF_OPTIONS (sizeof(options) / sizeof(struct clap_option))
 
-struct nanotest_error clap_smoke_test() {
+nanotest_test(clap_smoke_test) {
     size_t i;
     const char* argv[] = {
         "program_name",
@@ -50,7 +51,7 @@ struct nanotest_error clap_smoke_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_null_argv_test() {
+nanotest_test(clap_null_argv_test) {
     struct clap_value values[NUMBER_OF_OPTIONS];
     int free_args[NUMBER_OF_OPTIONS];
     int status;
@@ -71,7 +72,7 @@ struct nanotest_error clap_null_argv_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_null_options_test() {
+nanotest_test(clap_null_options_test) {
     struct clap_value values[NUMBER_OF_OPTIONS];
     int free_args[NUMBER_OF_OPTIONS];
     int status;
@@ -97,7 +98,7 @@ struct nanotest_error clap_null_options_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_null_values_test() {
+nanotest_test(clap_null_values_test) {
     int free_args[NUMBER_OF_OPTIONS];
     int status;
 
@@ -123,7 +124,7 @@ struct nanotest_error clap_null_values_test() {
 }
 
 
-struct nanotest_error clap_null_free_args_test() {
+nanotest_test(clap_null_free_args_test) {
     struct clap_value values[NUMBER_OF_OPTIONS];
     int status;
 
@@ -148,7 +149,7 @@ struct nanotest_error clap_null_free_args_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_only_free_argument_test() {
+nanotest_test(clap_only_free_argument_test) {
     size_t i;
     const char* argv[] = {
         "program_name",
@@ -198,7 +199,7 @@ struct nanotest_error clap_only_free_argument_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_only_letter_argument_test() {
+nanotest_test(clap_only_letter_argument_test) {
     size_t i;
     const char* argv[] = {
         "program_name",
@@ -245,7 +246,7 @@ struct nanotest_error clap_only_letter_argument_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_only_word_argument_test() {
+nanotest_test(clap_only_word_argument_test) {
     size_t i;
     const char* argv[] = {
         "program_name",
@@ -295,11 +296,167 @@ struct nanotest_error clap_only_word_argument_test() {
     nanotest_success();
 }
 
-struct nanotest_error clap_separator_test() {
+nanotest_test(clap_separator_test) {
+    size_t i;
+    const char* argv[] = {
+        "program_name",
+        "--",
+        "-a",
+        "--aword"
+    };
+    int argc = sizeof(argv) / sizeof(const char*);
+    struct clap_value values[NUMBER_OF_OPTIONS];
+    int free_args[NUMBER_OF_OPTIONS];
+    int status;
+
+    status = clap_parse(
+        argc,
+        argv,
+        NUMBER_OF_OPTIONS,
+        options,
+        values,
+        free_args);
+
+    nanotest_assert(
+        status == 0,
+        "Status code is not 0"
+        );
+
+    for (i = 0; i < NUMBER_OF_OPTIONS; ++i) {
+        nanotest_assert(
+            !values[i].enabled,
+            "Option was matched"
+            );
+    }
+
+    nanotest_assert(
+        free_args[0] == 0 && free_args[1] == 2 && free_args[2] == 3,
+        "Incorrect free_args elemenent value"
+        );
+    nanotest_assert(
+        free_args[3] == -1,
+        "free_args is not terminated with -1"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(clap_value_in_next_argument_test) {
+    const char* argv[] = {
+        "program_name",
+        "-b", "BVAL",
+        "--bword", "BWORDVAL",
+        "-d", "--aword",
+        "FREE_ARG"
+    };
+    int argc = sizeof(argv) / sizeof(const char*);
+    struct clap_value values[NUMBER_OF_OPTIONS];
+    int free_args[NUMBER_OF_OPTIONS];
+    int status;
+
+    status = clap_parse(
+        argc,
+        argv,
+        NUMBER_OF_OPTIONS,
+        options,
+        values,
+        free_args);
+
+    nanotest_assert(
+        status == 0,
+        "Status code is not 0"
+        );
+    nanotest_assert(
+        values[1].string != NULL && strcmp(values[1].string, "BVAL") == 0,
+        "Letter option value is not taken from the next argument"
+        );
+    nanotest_assert(
+        values[5].string != NULL && strcmp(values[5].string, "BWORDVAL") == 0,
+        "Word option value is not taken from the next argument"
+        );
+    nanotest_assert(
+        values[3].enabled && values[3].string == NULL,
+        "Optional value is taken from the next option"
+        );
+    nanotest_assert(
+        values[4].enabled,
+        "Option after optional value was not matched"
+        );
+    nanotest_assert(
+        free_args[0] == 0 && free_args[1] == 7 && free_args[2] == -1,
+        "Incorrect free_args elemenent value"
+        );
+
     nanotest_success();
 }
 
-struct nanotest_error clap_help_test() {
+nanotest_test(clap_missing_value_test) {
+    const char* argv[] = {
+        "program_name",
+        "-b"
+    };
+    int argc = sizeof(argv) / sizeof(const char*);
+    struct clap_value values[NUMBER_OF_OPTIONS];
+    int free_args[NUMBER_OF_OPTIONS];
+    int status;
+
+    status = clap_parse(
+        argc,
+        argv,
+        NUMBER_OF_OPTIONS,
+        options,
+        values,
+        free_args);
+
+    nanotest_assert(
+        status == 1,
+        "Status is not 1"
+        );
+    nanotest_assert(
+        values[1].enabled && values[1].string == NULL,
+        "Option without value has string"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(clap_grouped_letters_test) {
+    const char* argv[] = {
+        "program_name",
+        "-adDVAL"
+    };
+    int argc = sizeof(argv) / sizeof(const char*);
+    struct clap_value values[NUMBER_OF_OPTIONS];
+    int free_args[NUMBER_OF_OPTIONS];
+    int status;
+
+    status = clap_parse(
+        argc,
+        argv,
+        NUMBER_OF_OPTIONS,
+        options,
+        values,
+        free_args);
+
+    nanotest_assert(
+        status == 0,
+        "Status code is not 0"
+        );
+    nanotest_assert(
+        values[0].enabled,
+        "First letter of group was not matched"
+        );
+    nanotest_assert(
+        values[3].enabled
+            && values[3].string != NULL
+            && strcmp(values[3].string, "DVAL") == 0,
+        "Grouped letter value was not matched"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(clap_help_test) {
     FILE* temp;
     unsigned long fsize;
     char* string ;
@@ -338,16 +495,104 @@ struct nanotest_error clap_help_test() {
     nanotest_success();
 }
 
-int main() {
-    nanotest_run(clap_smoke_test);
-    nanotest_run(clap_null_argv_test);
-    nanotest_run(clap_null_options_test);
-    nanotest_run(clap_null_values_test);
-    nanotest_run(clap_null_free_args_test);
-    nanotest_run(clap_only_free_argument_test);
-    nanotest_run(clap_only_letter_argument_test);
-    nanotest_run(clap_only_word_argument_test);
-    nanotest_run(clap_separator_test);
-    nanotest_run(clap_help_test);
-    return 0;
+nanotest_test(clap_help_free_args_test) {
+    FILE* temp;
+    char string[64];
+    const char* free_args_names[] = {
+        "input",
+        "files",
+        NULL
+    };
+
+    temp = tmpfile();
+    clap_print_help(
+        temp,
+        "my_program",
+        3,
+        free_args_names,
+        0,
+        NULL
+        );
+
+    rewind(temp);
+    nanotest_assert(
+        fgets(string, sizeof(string), temp) != NULL
+            && strcmp(
+                string,
+                "Usage: my_program [options] input files...\n") == 0,
+        "Usage string not equal with expected"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(clap_parse_does_not_allocate_test) {
+    const char* argv[] = {
+        "program_name",
+        "-a",
+        "-bBVAL",
+        "-c", "CVAL",
+        "-adDVAL",
+        "--aword",
+        "--bword=BWORDVAL",
+        "--zword", "ZWORDVAL",
+        "FREE_ARG",
+        "--",
+        "-a"
+    };
+    int argc = sizeof(argv) / sizeof(const char*);
+    struct clap_value values[NUMBER_OF_OPTIONS];
+    int free_args[sizeof(argv) / sizeof(const char*) + 1];
+    struct nanotest_account account;
+
+    nanotest_skip_without_account();
+
+    nanotest_account_begin();
+    clap_parse(
+        argc,
+        argv,
+        NUMBER_OF_OPTIONS,
+        options,
+        values,
+        free_args);
+    nanotest_account_end(&account);
+
+    nanotest_assert_no_allocations(account);
+
+    nanotest_success();
+}
+
+nanotest_test(clap_help_bounded_writes_test) {
+    FILE* output;
+    struct nanotest_account account;
+
+    nanotest_skip_without_account();
+
+    output = nanotest_account_stream();
+    nanotest_assert(output != NULL, "Stream is not available");
+
+    nanotest_account_begin();
+    clap_print_help(
+        output,
+        "my_program",
+        0,
+        NULL,
+        NUMBER_OF_OPTIONS,
+        options
+        );
+    nanotest_account_end(&account);
+    fclose(output);
+
+    /*
+     * Usage, its end, options header and at most seven writes per option
+     * (indent, letter, separator, word, value, description and new line)
+     * regardless of lengths of strings
+     */
+    nanotest_assert_writes_at_most(account, 3 + 7 * (long)NUMBER_OF_OPTIONS);
+
+    nanotest_success();
+}
+
+int main(int argc, char* argv[]) {
+    return nanotest_main(argc, argv);
 }
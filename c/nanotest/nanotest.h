@@ -29,11 +29,25 @@ struct nanotest_error {
         return error;\
     } while (0)
 
+/* Skipped test reports its reason as message without source file */
+#define nanotest_skip(reason)\
+    do {\
+        struct nanotest_error error;\
+        error.source_file = NULL;\
+        error.line = 0;\
+        error.message = reason;\
+        return error;\
+    } while (0)
+
 #define nanotest_run(test)\
     do {\
         struct nanotest_error error;\
         printf("Running: %s ...", #test);\
         error = test();\
+        if (error.message && error.source_file == NULL) {\
+            printf(" SKIPPED\n%s\n", error.message);\
+            break;\
+        }\
         if (error.message) {\
             printf(" FAILED\n");\
             printf("%s:%d - %s",\
@@ -0,0 +1,148 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include "nanotest_account.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/**
+ * nanotest_accounting - counters updated by interposed functions
+ * @enabled: indicates that calls are being counted
+ * @account: calls counted so far
+ */
+static struct {
+    int enabled;
+    struct nanotest_account account;
+} nanotest_accounting;
+
+#if defined(__GLIBC__)
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/* glibc exports its implementations under these names for interposers */
+extern void* __libc_malloc(size_t size);
+extern void* __libc_calloc(size_t number, size_t size);
+extern void* __libc_realloc(void* pointer, size_t size);
+extern void __libc_free(void* pointer);
+extern ssize_t __write(int fd, const void* buffer, size_t size);
+
+void* malloc(size_t size) {
+    if (nanotest_accounting.enabled) {
+        nanotest_accounting.account.allocations++;
+    }
+    return __libc_malloc(size);
+}
+
+void* calloc(size_t number, size_t size) {
+    if (nanotest_accounting.enabled) {
+        nanotest_accounting.account.allocations++;
+    }
+    return __libc_calloc(number, size);
+}
+
+void* realloc(void* pointer, size_t size) {
+    if (nanotest_accounting.enabled) {
+        nanotest_accounting.account.allocations++;
+    }
+    return __libc_realloc(pointer, size);
+}
+
+void free(void* pointer) {
+    if (nanotest_accounting.enabled) {
+        nanotest_accounting.account.frees++;
+    }
+    __libc_free(pointer);
+}
+
+ssize_t write(int fd, const void* buffer, size_t size) {
+    if (nanotest_accounting.enabled) {
+        nanotest_accounting.account.writes++;
+    }
+    return __write(fd, buffer, size);
+}
+
+static ssize_t nanotest_account_sink_write(
+        void* cookie,
+        const char* buffer,
+        size_t size) {
+    return write(*(int*)cookie, buffer, size);
+}
+
+static int nanotest_account_sink_close(void* cookie) {
+    int result = close(*(int*)cookie);
+    free(cookie);
+    return result;
+}
+
+/**
+ * nanotest_account_available() - Routine for checking platform support
+ * NOTE: description of the function available in header file
+ */
+int nanotest_account_available(void) {
+    return 1;
+}
+
+/**
+ * nanotest_account_stream() - Routine for opening stream to count writes of
+ * NOTE: description of the function available in header file
+ */
+FILE* nanotest_account_stream(void) {
+    cookie_io_functions_t functions;
+    int* fd;
+    FILE* stream;
+
+    memset(&functions, 0, sizeof(functions));
+    functions.write = nanotest_account_sink_write;
+    functions.close = nanotest_account_sink_close;
+
+    fd = malloc(sizeof(int));
+    if (fd == NULL) {
+        return NULL;
+    }
+    *fd = open("/dev/null", O_WRONLY);
+    if (*fd < 0) {
+        free(fd);
+        return NULL;
+    }
+
+    stream = fopencookie(fd, "w", functions);
+    if (stream == NULL) {
+        nanotest_account_sink_close(fd);
+        return NULL;
+    }
+    setvbuf(stream, NULL, _IONBF, 0);
+
+    return stream;
+}
+
+#else /* __GLIBC__ */
+
+int nanotest_account_available(void) {
+    return 0;
+}
+
+FILE* nanotest_account_stream(void) {
+    return NULL;
+}
+
+#endif /* __GLIBC__ */
+
+/**
+ * nanotest_account_begin() - Routine for starting to count calls
+ */
+void nanotest_account_begin(void) {
+    memset(&nanotest_accounting.account, 0, sizeof(struct nanotest_account));
+    nanotest_accounting.enabled = 1;
+}
+
+/**
+ * nanotest_account_end() - Routine for stopping to count calls
+ * NOTE: description of function arguments available in header file
+ */
+void nanotest_account_end(struct nanotest_account* account) {
+    nanotest_accounting.enabled = 0;
+    *account = nanotest_accounting.account;
+}
@@ -0,0 +1,68 @@
+#ifndef NANOTEST_ACCOUNT_H
+#define NANOTEST_ACCOUNT_H
+
+#include "nanotest.h"
+
+/**
+ * struct nanotest_account - calls made between begin and end of accounting
+ * @allocations: number of malloc(), calloc() and realloc() calls
+ * @frees: number of free() calls
+ * @writes: number of write() calls
+ */
+struct nanotest_account {
+    long allocations;
+    long frees;
+    long writes;
+};
+
+/**
+ * nanotest_account_available() - Routine for checking platform support
+ *
+ * Accounting relies on interposition of C library functions and is
+ * implemented for glibc only, elsewhere all counters stay zero.
+ *
+ * Return: 1 if calls are counted, 0 otherwise
+ */
+int nanotest_account_available(void);
+
+/**
+ * nanotest_account_begin() - Routine for starting to count calls
+ */
+void nanotest_account_begin(void);
+
+/**
+ * nanotest_account_end() - Routine for stopping to count calls
+ * @account: output data with calls made since nanotest_account_begin()
+ */
+void nanotest_account_end(struct nanotest_account* account);
+
+/**
+ * nanotest_account_stream() - Routine for opening stream to count writes of
+ *
+ * C library streams write through internal functions that can not be
+ * interposed, so this unbuffered stream (just like stderr) passes
+ * every chunk of its output to write() into null device instead.
+ *
+ * Return: stream to be closed by fclose(), null pointer if not available
+ */
+FILE* nanotest_account_stream(void);
+
+/* Ends test as skipped if calls are not counted on this platform */
+#define nanotest_skip_without_account()\
+    do {\
+        if (!nanotest_account_available()) {\
+            nanotest_skip("Memory accounting is not available");\
+        }\
+    } while (0)
+
+#define nanotest_assert_no_allocations(account)\
+    nanotest_assert(\
+        (account).allocations == 0,\
+        "Memory was allocated")
+
+#define nanotest_assert_writes_at_most(account, limit)\
+    nanotest_assert(\
+        (account).writes <= (limit),\
+        "Too many write calls")
+
+#endif /* NANOTEST_ACCOUNT_H */
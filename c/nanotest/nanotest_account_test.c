@@ -0,0 +1,70 @@
+#include "nanotest_runner.h"
+#include "nanotest_account.h"
+
+/* Stored pointer keeps allocation from being optimised out */
+static void* volatile nanotest_account_pointer;
+
+nanotest_test(account_counts_allocations_test) {
+    struct nanotest_account account;
+
+    nanotest_skip_without_account();
+
+    nanotest_account_begin();
+    nanotest_account_pointer = malloc(16);
+    nanotest_account_pointer = realloc(nanotest_account_pointer, 32);
+    free(nanotest_account_pointer);
+    nanotest_account_end(&account);
+
+    nanotest_assert(
+        account.allocations == 2,
+        "Allocations were not counted"
+        );
+    nanotest_assert(
+        account.frees == 1,
+        "Frees were not counted"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(account_counts_stream_writes_test) {
+    FILE* output;
+    struct nanotest_account account;
+
+    nanotest_skip_without_account();
+
+    output = nanotest_account_stream();
+    nanotest_assert(output != NULL, "Stream is not available");
+
+    nanotest_account_begin();
+    fprintf(output, "%s", "first");
+    fprintf(output, "%s", "second");
+    nanotest_account_end(&account);
+    fclose(output);
+
+    nanotest_assert(
+        account.writes == 2,
+        "Stream writes were not counted"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(account_stops_counting_test) {
+    struct nanotest_account account;
+
+    nanotest_account_begin();
+    nanotest_account_end(&account);
+    nanotest_account_pointer = malloc(16);
+    free(nanotest_account_pointer);
+    nanotest_account_begin();
+    nanotest_account_end(&account);
+
+    nanotest_assert_no_allocations(account);
+
+    nanotest_success();
+}
+
+int main(int argc, char* argv[]) {
+    return nanotest_main(argc, argv);
+}
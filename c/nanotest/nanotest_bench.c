@@ -0,0 +1,504 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#endif
+
+#include "nanotest_bench.h"
+#include "clap.h"
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+/* Sample shorter than that is dominated by timer resolution */
+#define NANOTEST_BENCH_SAMPLE_TIME 1e-3
+
+static double nanotest_bench_now(void) {
+#if defined(_WIN32)
+    LARGE_INTEGER counter;
+    LARGE_INTEGER frequency;
+    QueryPerformanceCounter(&counter);
+    QueryPerformanceFrequency(&frequency);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#elif defined(CLOCK_MONOTONIC)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+#else
+    return (double)clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static double nanotest_bench_time(
+        const struct nanotest_bench* bench,
+        long iterations) {
+    double start = nanotest_bench_now();
+    long i;
+
+    for (i = 0; i < iterations; ++i) {
+        bench->function();
+    }
+
+    return nanotest_bench_now() - start;
+}
+
+static int nanotest_bench_compare_doubles(
+        const void* left,
+        const void* right) {
+    double difference = *(const double*)left - *(const double*)right;
+    return (difference > 0) - (difference < 0);
+}
+
+/* Sorts values in place */
+static double nanotest_bench_median(double* values, int length) {
+    qsort(
+        values,
+        (size_t)length,
+        sizeof(double),
+        nanotest_bench_compare_doubles);
+
+    return length % 2
+        ? values[length / 2]
+        : (values[length / 2 - 1] + values[length / 2]) / 2;
+}
+
+/**
+ * nanotest_bench_measure() - Routine for timing benchmark
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_bench_measure(
+        const struct nanotest_bench* bench,
+        int samples,
+        struct nanotest_bench_result* result) {
+    struct nanotest_perf perf;
+    int status;
+
+    nanotest_perf_open(&perf);
+    status = nanotest_bench_measure_with(bench, samples, &perf, result);
+    nanotest_perf_close(&perf);
+
+    return status;
+}
+
+/**
+ * nanotest_bench_measure_with() - Routine for timing benchmark
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_bench_measure_with(
+        const struct nanotest_bench* bench,
+        int samples,
+        const struct nanotest_perf* perf,
+        struct nanotest_bench_result* result) {
+    struct nanotest_perf_reading before;
+    struct nanotest_perf_reading after;
+    double counters[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+    double* times;
+    double* events;
+    double spread;
+    long iterations = 1;
+    int low;
+    int high;
+    int i;
+    int j;
+
+    if (bench == NULL || perf == NULL || result == NULL || samples <= 0) {
+        return 1;
+    }
+
+    times = malloc(sizeof(double) * (size_t)samples);
+    /* Events of every counter are stored in consecutive samples slots */
+    events = malloc(
+        sizeof(double) * (size_t)samples * NANOTEST_PERF_NUMBER_OF_COUNTERS);
+    if (times == NULL || events == NULL) {
+        free(times);
+        free(events);
+        return 1;
+    }
+
+    /* Warm up caches and find number of calls filling a sample */
+    while (nanotest_bench_time(bench, iterations) < NANOTEST_BENCH_SAMPLE_TIME
+            && iterations < 0x20000000L) {
+        iterations *= 2;
+    }
+
+    for (i = 0; i < samples; ++i) {
+        nanotest_perf_read(perf, &before);
+        times[i] = nanotest_bench_time(bench, iterations) * 1e9
+            / (double)iterations;
+        nanotest_perf_read(perf, &after);
+        nanotest_perf_delta(&before, &after, counters);
+        for (j = 0; j < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++j) {
+            events[j * samples + i] = counters[j] >= 0
+                ? counters[j] / (double)iterations
+                : -1;
+        }
+    }
+
+    for (j = 0; j < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++j) {
+        result->counters[j]
+            = nanotest_bench_median(events + j * samples, samples);
+    }
+
+    /* Ranks bounding 95% confidence interval of median */
+    spread = 1.96 * sqrt((double)samples) / 2;
+    low = (int)floor((samples - 1) / 2.0 - spread);
+    high = (int)ceil((samples - 1) / 2.0 + spread);
+
+    strncpy(result->name, bench->name, sizeof(result->name) - 1);
+    result->name[sizeof(result->name) - 1] = 0;
+    result->median = nanotest_bench_median(times, samples);
+    result->low = times[low < 0 ? 0 : low];
+    result->high = times[high >= samples ? samples - 1 : high];
+    result->iterations = iterations;
+
+    free(events);
+    free(times);
+    return 0;
+}
+
+/**
+ * nanotest_bench_save() - Routine for writing results as text lines
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_bench_save(
+        FILE* output,
+        int number_of_results,
+        const struct nanotest_bench_result* results) {
+    int i;
+
+    fprintf(output, "# name median_ns low_ns high_ns iterations\n");
+    for (i = 0; i < number_of_results; ++i) {
+        fprintf(
+            output,
+            "%s %.3f %.3f %.3f %ld\n",
+            results[i].name,
+            results[i].median,
+            results[i].low,
+            results[i].high,
+            results[i].iterations);
+    }
+
+    return ferror(output) != 0;
+}
+
+/**
+ * nanotest_bench_load() - Routine for reading results written by save
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_bench_load(
+        FILE* input,
+        int capacity,
+        struct nanotest_bench_result* results) {
+    char line[256];
+    int number_of_results = 0;
+
+    while (fgets(line, sizeof(line), input) != NULL) {
+        struct nanotest_bench_result* result = &results[number_of_results];
+        char name[256];
+
+        if (line[0] == '#' || line[strspn(line, " \t\r\n")] == 0) {
+            continue;
+        }
+        if (number_of_results == capacity
+                || sscanf(
+                    line,
+                    "%255s %lf %lf %lf %ld",
+                    name,
+                    &result->median,
+                    &result->low,
+                    &result->high,
+                    &result->iterations) != 5
+                || strlen(name) >= sizeof(result->name)) {
+            return -1;
+        }
+        strcpy(result->name, name);
+        ++number_of_results;
+    }
+
+    return ferror(input) ? -1 : number_of_results;
+}
+
+/**
+ * nanotest_bench_compare() - Routine for reporting changes against baseline
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_bench_compare(
+        int number_of_results,
+        const struct nanotest_bench_result* results,
+        int number_of_baselines,
+        const struct nanotest_bench_result* baselines,
+        double threshold) {
+    int regressions = 0;
+    int i;
+    int j;
+
+    for (i = 0; i < number_of_results; ++i) {
+        const struct nanotest_bench_result* current = &results[i];
+        const struct nanotest_bench_result* baseline = NULL;
+        const char* verdict = "OK";
+        double ratio;
+
+        for (j = 0; j < number_of_baselines && baseline == NULL; ++j) {
+            if (strcmp(baselines[j].name, current->name) == 0) {
+                baseline = &baselines[j];
+            }
+        }
+
+        if (baseline == NULL || baseline->median <= 0) {
+            printf("%s: no baseline\n", current->name);
+            continue;
+        }
+
+        ratio = current->median / baseline->median;
+        if (ratio > 1 + threshold && current->low > baseline->high) {
+            verdict = "REGRESSION";
+            ++regressions;
+        }
+        else if (ratio < 1 - threshold && current->high < baseline->low) {
+            verdict = "IMPROVEMENT";
+        }
+
+        printf(
+            "%s: %.1f ns -> %.1f ns (%+.1f%%) %s\n",
+            current->name,
+            baseline->median,
+            current->median,
+            (ratio - 1) * 100,
+            verdict);
+    }
+
+    return regressions;
+}
+
+/**
+ * nanotest_bench_counter_names - names of enum nanotest_perf_counter items
+ */
+static const char* nanotest_bench_counter_names[] = {
+    "cycles",
+    "instructions",
+    "branch misses",
+    "L1d misses",
+    "LLC misses"
+};
+
+/**
+ * nanotest_bench_print_counters() - Routine for printing events per call
+ * @result: measured benchmark
+ *
+ * Return: 1 if any counter was printed, 0 otherwise
+ */
+static int nanotest_bench_print_counters(
+        const struct nanotest_bench_result* result) {
+    const double* counters = result->counters;
+    const char* separator = "  ";
+    int printed = 0;
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        if (counters[i] < 0) {
+            continue;
+        }
+        printf(
+            "%s%.1f %s",
+            separator,
+            counters[i],
+            nanotest_bench_counter_names[i]);
+        if (i == NANOTEST_PERF_INSTRUCTIONS
+                && counters[NANOTEST_PERF_CYCLES] > 0) {
+            printf(
+                " (%.2f IPC)",
+                counters[i] / counters[NANOTEST_PERF_CYCLES]);
+        }
+        separator = ", ";
+        printed = 1;
+    }
+    if (printed) {
+        printf(" per call\n");
+    }
+
+    return printed;
+}
+
+static int nanotest_bench_parse_number(const char* string, double* number) {
+    char* end;
+
+    if (string == NULL) {
+        return 1;
+    }
+    *number = strtod(string, &end);
+    return end == string || *end != 0 || *number < 0;
+}
+
+/* Returns number of regressions, -1 if baseline can not be read */
+static int nanotest_bench_compare_file(
+        const char* path,
+        int number_of_results,
+        const struct nanotest_bench_result* results,
+        double threshold) {
+    struct nanotest_bench_result* baselines;
+    int number_of_baselines;
+    int regressions;
+    FILE* input;
+
+    input = fopen(path, "r");
+    if (input == NULL) {
+        fprintf(stderr, "nanotest: unable to open baseline %s\n", path);
+        return -1;
+    }
+
+    /* Baseline may contain benchmarks removed since it was written */
+    baselines = malloc(sizeof(struct nanotest_bench_result) * 1024);
+    number_of_baselines = baselines == NULL
+        ? -1
+        : nanotest_bench_load(input, 1024, baselines);
+    fclose(input);
+    if (number_of_baselines < 0) {
+        fprintf(stderr, "nanotest: unable to read baseline %s\n", path);
+        free(baselines);
+        return -1;
+    }
+
+    printf("Comparing with %s (threshold %.1f%%):\n", path, threshold * 100);
+    regressions = nanotest_bench_compare(
+        number_of_results,
+        results,
+        number_of_baselines,
+        baselines,
+        threshold);
+    printf("Regressions: %d\n", regressions);
+
+    free(baselines);
+    return regressions;
+}
+
+/**
+ * nanotest_bench_options - options accepted by nanotest_bench_main()
+ */
+static const struct clap_option nanotest_bench_options[] = {
+    { 'h', "help", CLAP_NO_VALUE, "prints help" },
+    { 'n', "samples", CLAP_VALUE_REQUIRED, "number of samples, 31 default" },
+    { 'o', "output", CLAP_VALUE_REQUIRED, "file to write results into" },
+    { 'b', "baseline", CLAP_VALUE_REQUIRED, "file to compare results with" },
+    { 't', "threshold", CLAP_VALUE_REQUIRED, "allowed slowdown, 10% default" },
+    { 'r', "report", CLAP_NO_VALUE, "does not fail on regressions" }
+};
+
+enum {
+    NANOTEST_BENCH_HELP,
+    NANOTEST_BENCH_SAMPLES,
+    NANOTEST_BENCH_OUTPUT,
+    NANOTEST_BENCH_BASELINE,
+    NANOTEST_BENCH_THRESHOLD,
+    NANOTEST_BENCH_REPORT,
+    NANOTEST_BENCH_NUMBER_OF_OPTIONS
+};
+
+/**
+ * nanotest_bench_main() - Routine for running benchmarks as main() does
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_bench_main(
+        int argc,
+        char* argv[],
+        int number_of_benches,
+        const struct nanotest_bench* benches) {
+    struct clap_value values[NANOTEST_BENCH_NUMBER_OF_OPTIONS];
+    struct nanotest_bench_result* results = NULL;
+    int* free_args;
+    int counted = 0;
+    double samples = 31;
+    double threshold = 10;
+    int result = 1;
+    int i;
+
+    memset(values, 0, sizeof(values));
+
+    free_args = malloc(sizeof(int) * ((size_t)argc + 1));
+    if (free_args == NULL || (number_of_benches > 0 && (results = malloc(
+            sizeof(struct nanotest_bench_result)
+            * (size_t)number_of_benches)) == NULL)) {
+        fprintf(stderr, "nanotest: out of memory\n");
+        goto cleanup;
+    }
+
+    if (clap_parse(
+                argc,
+                (const char**)argv,
+                NANOTEST_BENCH_NUMBER_OF_OPTIONS,
+                nanotest_bench_options,
+                values,
+                free_args) != 0
+            || (values[NANOTEST_BENCH_SAMPLES].enabled
+                && (nanotest_bench_parse_number(
+                    values[NANOTEST_BENCH_SAMPLES].string, &samples) != 0
+                    || samples < 1 || samples > 100000))
+            || (values[NANOTEST_BENCH_THRESHOLD].enabled
+                && nanotest_bench_parse_number(
+                    values[NANOTEST_BENCH_THRESHOLD].string, &threshold) != 0)
+            || values[NANOTEST_BENCH_HELP].enabled) {
+        clap_print_help(
+            values[NANOTEST_BENCH_HELP].enabled ? stdout : stderr,
+            argv[0],
+            0,
+            NULL,
+            NANOTEST_BENCH_NUMBER_OF_OPTIONS,
+            nanotest_bench_options);
+        result = !values[NANOTEST_BENCH_HELP].enabled;
+        goto cleanup;
+    }
+
+    for (i = 0; i < number_of_benches; ++i) {
+        struct nanotest_bench_result* current = &results[i];
+        if (nanotest_bench_measure(&benches[i], (int)samples, current) != 0) {
+            fprintf(
+                stderr,
+                "nanotest: unable to measure %s\n",
+                benches[i].name);
+            goto cleanup;
+        }
+        printf(
+            "%s: %.1f ns [%.1f, %.1f], %.0f calls/s\n",
+            current->name,
+            current->median,
+            current->low,
+            current->high,
+            current->median > 0 ? 1e9 / current->median : 0);
+        counted |= nanotest_bench_print_counters(current);
+    }
+    if (!counted) {
+        printf("Hardware counters are not available, only time is measured\n");
+    }
+
+    if (values[NANOTEST_BENCH_OUTPUT].enabled) {
+        FILE* output = fopen(values[NANOTEST_BENCH_OUTPUT].string, "w");
+        int status = output == NULL
+            || nanotest_bench_save(output, number_of_benches, results) != 0;
+        if ((output != NULL && fclose(output) != 0) || status != 0) {
+            fprintf(
+                stderr,
+                "nanotest: unable to write %s\n",
+                values[NANOTEST_BENCH_OUTPUT].string);
+            goto cleanup;
+        }
+    }
+
+    result = 0;
+    if (values[NANOTEST_BENCH_BASELINE].enabled) {
+        int regressions = nanotest_bench_compare_file(
+            values[NANOTEST_BENCH_BASELINE].string,
+            number_of_benches,
+            results,
+            threshold / 100);
+        result = regressions < 0
+            || (regressions > 0 && !values[NANOTEST_BENCH_REPORT].enabled);
+    }
+
+cleanup:
+    free(results);
+    free(free_args);
+    return result;
+}
@@ -0,0 +1,143 @@
+#ifndef NANOTEST_BENCH_H
+#define NANOTEST_BENCH_H
+
+#include "nanotest_perf.h"
+
+#include <stdio.h>
+
+/**
+ * struct nanotest_bench - named benchmark function
+ * @name: name of the benchmark used in reports and baseline files
+ * @function: routine being measured, it is called repeatedly
+ */
+struct nanotest_bench {
+    const char* name;
+    void (*function)(void);
+};
+
+/* Initializer of struct nanotest_bench named after function itself */
+#define nanotest_bench(function) { #function, function }
+
+/* Maximum length of benchmark name stored in baseline file */
+#define NANOTEST_BENCH_NAME_LENGTH 64
+
+/**
+ * struct nanotest_bench_result - timing of a single benchmark
+ * @name: name of the benchmark
+ * @median: median of samples in nanoseconds per call
+ * @low: lower bound of 95% confidence interval of median
+ * @high: upper bound of 95% confidence interval of median
+ * @iterations: number of calls measured by every sample
+ * @counters: median of hardware events per call indexed by
+ *            enum nanotest_perf_counter, negative if event is not counted
+ */
+struct nanotest_bench_result {
+    char name[NANOTEST_BENCH_NAME_LENGTH];
+    double median;
+    double low;
+    double high;
+    long iterations;
+    double counters[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+};
+
+/**
+ * nanotest_bench_measure() - Routine for timing benchmark
+ * @bench: benchmark to measure
+ * @samples: number of samples to take, every one lasts about a millisecond
+ * @result: output data
+ *
+ * Hardware counters are read around every sample if nanotest_perf_open()
+ * succeeds, otherwise only time is measured.
+ *
+ * Return: 0 if everything was successful
+ */
+int nanotest_bench_measure(
+    const struct nanotest_bench* bench,
+    int samples,
+    struct nanotest_bench_result* result);
+
+/**
+ * nanotest_bench_measure_with() - Routine for timing benchmark
+ * @bench: benchmark to measure
+ * @samples: number of samples to take, every one lasts about a millisecond
+ * @perf: counters opened by caller, read around every sample
+ * @result: output data
+ *
+ * Return: 0 if everything was successful
+ */
+int nanotest_bench_measure_with(
+    const struct nanotest_bench* bench,
+    int samples,
+    const struct nanotest_perf* perf,
+    struct nanotest_bench_result* result);
+
+/**
+ * nanotest_bench_save() - Routine for writing results as text lines
+ * @output: file to write into
+ * @number_of_results: length of results array
+ * @results: results to write
+ *
+ * Every line is "name median low high iterations", lines starting
+ * with '#' are comments. Hardware counters are not saved.
+ *
+ * Return: 0 if everything was successful
+ */
+int nanotest_bench_save(
+    FILE* output,
+    int number_of_results,
+    const struct nanotest_bench_result* results);
+
+/**
+ * nanotest_bench_load() - Routine for reading results written by save
+ * @input: file to read from
+ * @capacity: length of results array
+ * @results: output data
+ *
+ * Return: number of read results, -1 if file is malformed or too long
+ */
+int nanotest_bench_load(
+    FILE* input,
+    int capacity,
+    struct nanotest_bench_result* results);
+
+/**
+ * nanotest_bench_compare() - Routine for reporting changes against baseline
+ * @number_of_results: length of results array
+ * @results: current results
+ * @number_of_baselines: length of baselines array
+ * @baselines: stored results to compare with
+ * @threshold: relative slowdown tolerated, e.g. 0.05 for 5%
+ *
+ * Benchmark regressed if its median grew by more than threshold and
+ * confidence intervals of current and baseline medians do not overlap,
+ * so both noise and negligible slowdowns are tolerated.
+ *
+ * Return: number of regressed benchmarks
+ */
+int nanotest_bench_compare(
+    int number_of_results,
+    const struct nanotest_bench_result* results,
+    int number_of_baselines,
+    const struct nanotest_bench_result* baselines,
+    double threshold);
+
+/**
+ * nanotest_bench_main() - Routine for running benchmarks as main() does
+ * @argc: main argc corresponding argument
+ * @argv: main argv corresponding argument
+ * @number_of_benches: length of benches array
+ * @benches: benchmarks to run
+ *
+ * Results are written to --output file and compared with --baseline file
+ * if those are given. Run with --help for description of all options.
+ *
+ * Return: 0 if everything was successful and nothing regressed,
+ *         regressions are only reported with --report option
+ */
+int nanotest_bench_main(
+    int argc,
+    char* argv[],
+    int number_of_benches,
+    const struct nanotest_bench* benches);
+
+#endif /* NANOTEST_BENCH_H */
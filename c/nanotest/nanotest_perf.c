@@ -0,0 +1,221 @@
+#if defined(__linux__)
+#define _GNU_SOURCE
+#endif
+
+#include "nanotest_perf.h"
+
+#include <string.h>
+
+#if defined(__linux__)
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+/**
+ * nanotest_perf_events - perf_event_open() type and config of counters
+ * and index of counter that should lead their group
+ */
+static const struct {
+    unsigned type;
+    unsigned long config;
+    int leader;
+} nanotest_perf_events[NANOTEST_PERF_NUMBER_OF_COUNTERS] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, NANOTEST_PERF_CYCLES },
+    {
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_INSTRUCTIONS,
+        NANOTEST_PERF_CYCLES
+    },
+    {
+        PERF_TYPE_HARDWARE,
+        PERF_COUNT_HW_BRANCH_MISSES,
+        NANOTEST_PERF_BRANCH_MISSES
+    },
+    {
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_L1D
+            | PERF_COUNT_HW_CACHE_OP_READ << 8
+            | PERF_COUNT_HW_CACHE_RESULT_MISS << 16,
+        NANOTEST_PERF_L1D_MISSES
+    },
+    {
+        PERF_TYPE_HW_CACHE,
+        PERF_COUNT_HW_CACHE_LL
+            | PERF_COUNT_HW_CACHE_OP_READ << 8
+            | PERF_COUNT_HW_CACHE_RESULT_MISS << 16,
+        NANOTEST_PERF_LLC_MISSES
+    }
+};
+
+/**
+ * nanotest_perf_open() - Routine for opening counters
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_perf_open(struct nanotest_perf* perf) {
+    int opened = 0;
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        struct perf_event_attr attr;
+        int leader = nanotest_perf_events[i].leader;
+        int group = -1;
+
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = nanotest_perf_events[i].type;
+        attr.config = nanotest_perf_events[i].config;
+        attr.read_format = PERF_FORMAT_GROUP
+            | PERF_FORMAT_TOTAL_TIME_ENABLED
+            | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        /* Kernel events are usually forbidden by perf_event_paranoid */
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        /* Counter is left alone if leader of its group failed to open */
+        if (leader != i && perf->fds[leader] != -1) {
+            group = perf->fds[leader];
+        }
+        else {
+            leader = i;
+        }
+
+        perf->fds[i]
+            = (int)syscall(SYS_perf_event_open, &attr, 0, -1, group, 0);
+        if (perf->fds[i] < 0) {
+            perf->fds[i] = -1;
+            perf->leaders[i] = -1;
+        }
+        else {
+            perf->leaders[i] = leader;
+            ++opened;
+        }
+    }
+
+    return opened;
+}
+
+/**
+ * nanotest_perf_read() - Routine for reading current counter state
+ * NOTE: description of function arguments available in header file
+ */
+void nanotest_perf_read(
+        const struct nanotest_perf* perf,
+        struct nanotest_perf_reading* reading) {
+    int i;
+    int j;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        reading->values[i] = -1;
+        reading->enabled[i] = 0;
+        reading->running[i] = 0;
+    }
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        /* number of values, time enabled, time running, values */
+        __u64 data[3 + NANOTEST_PERF_NUMBER_OF_COUNTERS];
+        ssize_t length;
+        __u64 member = 0;
+
+        if (perf->leaders[i] != i) {
+            continue;
+        }
+        length = read(perf->fds[i], data, sizeof(data));
+        if (length < (ssize_t)(3 * sizeof(__u64))) {
+            continue;
+        }
+
+        /* Values of group members follow in order they were opened */
+        for (j = i; j < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++j) {
+            if (perf->leaders[j] != i) {
+                continue;
+            }
+            if (member >= data[0]
+                    || (size_t)length < (4 + member) * sizeof(__u64)) {
+                break;
+            }
+            reading->values[j] = (double)data[3 + member];
+            reading->enabled[j] = (double)data[1];
+            reading->running[j] = (double)data[2];
+            ++member;
+        }
+    }
+}
+
+/**
+ * nanotest_perf_close() - Routine for closing counters
+ * NOTE: description of function arguments available in header file
+ */
+void nanotest_perf_close(struct nanotest_perf* perf) {
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        if (perf->fds[i] != -1) {
+            close(perf->fds[i]);
+            perf->fds[i] = -1;
+        }
+        perf->leaders[i] = -1;
+    }
+}
+
+#else /* __linux__ */
+
+int nanotest_perf_open(struct nanotest_perf* perf) {
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        perf->fds[i] = -1;
+        perf->leaders[i] = -1;
+    }
+
+    return 0;
+}
+
+void nanotest_perf_read(
+        const struct nanotest_perf* perf,
+        struct nanotest_perf_reading* reading) {
+    int i;
+
+    (void)perf;
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        reading->values[i] = -1;
+        reading->enabled[i] = 0;
+        reading->running[i] = 0;
+    }
+}
+
+void nanotest_perf_close(struct nanotest_perf* perf) {
+    (void)perf;
+}
+
+#endif /* __linux__ */
+
+/**
+ * nanotest_perf_delta() - Routine for counting events between readings
+ * NOTE: description of function arguments available in header file
+ */
+void nanotest_perf_delta(
+        const struct nanotest_perf_reading* before,
+        const struct nanotest_perf_reading* after,
+        double values[NANOTEST_PERF_NUMBER_OF_COUNTERS]) {
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        double events = after->values[i] - before->values[i];
+        double enabled = after->enabled[i] - before->enabled[i];
+        double running = after->running[i] - before->running[i];
+
+        values[i] = -1;
+        if (before->values[i] < 0 || after->values[i] < 0) {
+            continue;
+        }
+        if (running < enabled) {
+            /* Counter was not scheduled at all during the interval */
+            if (running <= 0) {
+                continue;
+            }
+            events *= enabled / running;
+        }
+        values[i] = events;
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef NANOTEST_PERF_H
+#define NANOTEST_PERF_H
+
+/**
+ * enum nanotest_perf_counter - hardware events counted for benchmarks
+ * @NANOTEST_PERF_CYCLES: CPU cycles
+ * @NANOTEST_PERF_INSTRUCTIONS: retired instructions
+ * @NANOTEST_PERF_BRANCH_MISSES: mispredicted branches
+ * @NANOTEST_PERF_L1D_MISSES: level 1 data cache read misses
+ * @NANOTEST_PERF_LLC_MISSES: last level cache read misses
+ */
+enum nanotest_perf_counter {
+    NANOTEST_PERF_CYCLES,
+    NANOTEST_PERF_INSTRUCTIONS,
+    NANOTEST_PERF_BRANCH_MISSES,
+    NANOTEST_PERF_L1D_MISSES,
+    NANOTEST_PERF_LLC_MISSES,
+    NANOTEST_PERF_NUMBER_OF_COUNTERS
+};
+
+/**
+ * struct nanotest_perf - set of opened counters of the calling thread
+ * @fds: descriptors of counters, -1 for counters not available
+ * @leaders: index of counter leading group of this one, -1 for counters
+ *           not available
+ */
+struct nanotest_perf {
+    int fds[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+    int leaders[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+};
+
+/**
+ * struct nanotest_perf_reading - raw counter state at some moment
+ * @values: events counted so far, negative for counters not available
+ * @enabled: time counter was enabled for
+ * @running: time counter was actually counting for
+ */
+struct nanotest_perf_reading {
+    double values[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+    double enabled[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+    double running[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+};
+
+/**
+ * nanotest_perf_open() - Routine for opening counters
+ * @perf: output data
+ *
+ * Counters are implemented with perf_event_open() on Linux only.
+ * Instructions are grouped with cycles, so both are always counted over
+ * the same time and give consistent IPC. Other counters are opened
+ * independently, so any of them may be missing in containers, virtual
+ * machines or with restricted perf_event_paranoid.
+ *
+ * Return: number of opened counters, 0 means timing only
+ */
+int nanotest_perf_open(struct nanotest_perf* perf);
+
+/**
+ * nanotest_perf_read() - Routine for reading current counter state
+ * @perf: opened counters
+ * @reading: output data
+ */
+void nanotest_perf_read(
+    const struct nanotest_perf* perf,
+    struct nanotest_perf_reading* reading);
+
+/**
+ * nanotest_perf_delta() - Routine for counting events between readings
+ * @before: reading taken first
+ * @after: reading taken last
+ * @values: output data, negative for counters not available
+ *
+ * If kernel had to multiplex counters in between, events are scaled
+ * by the ratio of enabled to running time of this very interval.
+ */
+void nanotest_perf_delta(
+    const struct nanotest_perf_reading* before,
+    const struct nanotest_perf_reading* after,
+    double values[NANOTEST_PERF_NUMBER_OF_COUNTERS]);
+
+/**
+ * nanotest_perf_close() - Routine for closing counters
+ * @perf: opened counters
+ */
+void nanotest_perf_close(struct nanotest_perf* perf);
+
+#endif /* NANOTEST_PERF_H */
@@ -0,0 +1,126 @@
+#include "nanotest_runner.h"
+#include "nanotest_bench.h"
+
+/* Stored sum keeps benchmark loop from being optimised out */
+static volatile long nanotest_perf_sum;
+
+static void nanotest_perf_work(void) {
+    int i;
+
+    for (i = 0; i < 16; ++i) {
+        nanotest_perf_sum += i;
+    }
+}
+
+static void nanotest_perf_unopened(struct nanotest_perf* perf) {
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        perf->fds[i] = -1;
+        perf->leaders[i] = -1;
+    }
+}
+
+nanotest_test(perf_unopened_counters_are_not_counted_test) {
+    struct nanotest_perf perf;
+    struct nanotest_perf_reading before;
+    struct nanotest_perf_reading after;
+    double values[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+    int i;
+
+    nanotest_perf_unopened(&perf);
+    nanotest_perf_read(&perf, &before);
+    nanotest_perf_read(&perf, &after);
+    nanotest_perf_delta(&before, &after, values);
+    nanotest_perf_close(&perf);
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        nanotest_assert(after.values[i] < 0, "Unopened counter was read");
+        nanotest_assert(values[i] < 0, "Unopened counter was counted");
+        nanotest_assert(perf.fds[i] == -1, "Unopened counter was changed");
+    }
+
+    nanotest_success();
+}
+
+nanotest_test(perf_open_read_close_test) {
+    struct nanotest_perf perf;
+    struct nanotest_perf_reading reading;
+    int opened = nanotest_perf_open(&perf);
+    int i;
+
+    nanotest_perf_read(&perf, &reading);
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        if (perf.fds[i] != -1) {
+            --opened;
+        }
+        else {
+            nanotest_assert(perf.leaders[i] == -1, "Missing counter leads");
+            nanotest_assert(reading.values[i] < 0, "Missing counter was read");
+        }
+    }
+    nanotest_perf_close(&perf);
+
+    nanotest_assert(opened == 0, "Opened counters are miscounted");
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        nanotest_assert(perf.fds[i] == -1, "Counter was not closed");
+    }
+
+    nanotest_success();
+}
+
+nanotest_test(perf_delta_is_scaled_per_interval_test) {
+    struct nanotest_perf_reading before;
+    struct nanotest_perf_reading after;
+    double values[NANOTEST_PERF_NUMBER_OF_COUNTERS];
+    int i;
+
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        before.values[i] = 1000;
+        before.enabled[i] = 1000;
+        before.running[i] = 100;
+        after.values[i] = 1100;
+        after.enabled[i] = 1200;
+        after.running[i] = 200;
+    }
+    /* Counter multiplexed out for the whole interval */
+    after.running[NANOTEST_PERF_LLC_MISSES] = 100;
+
+    nanotest_perf_delta(&before, &after, values);
+
+    nanotest_assert(
+        values[NANOTEST_PERF_CYCLES] == 200,
+        "Delta is not scaled by time of the interval"
+        );
+    nanotest_assert(
+        values[NANOTEST_PERF_LLC_MISSES] < 0,
+        "Counter not running in the interval was counted"
+        );
+
+    nanotest_success();
+}
+
+nanotest_test(bench_measure_without_counters_test) {
+    static const struct nanotest_bench bench
+        = nanotest_bench(nanotest_perf_work);
+    struct nanotest_perf perf;
+    struct nanotest_bench_result result;
+    int i;
+
+    nanotest_perf_unopened(&perf);
+    nanotest_assert(
+        nanotest_bench_measure_with(&bench, 3, &perf, &result) == 0,
+        "Benchmark was not measured"
+        );
+
+    nanotest_assert(result.median > 0, "Time was not measured");
+    for (i = 0; i < NANOTEST_PERF_NUMBER_OF_COUNTERS; ++i) {
+        nanotest_assert(result.counters[i] < 0, "Counter was filled");
+    }
+
+    nanotest_success();
+}
+
+int main(int argc, char* argv[]) {
+    return nanotest_main(argc, argv);
+}
@@ -0,0 +1,915 @@
+#if !defined(_WIN32)
+#define _POSIX_C_SOURCE 200112L
+#define NANOTEST_RUNNER_FORK
+#endif
+
+#include "nanotest_runner.h"
+#include "clap.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef NANOTEST_RUNNER_FORK
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+/**
+ * struct nanotest_summary - results aggregated over finished tests
+ * @passed: number of passed tests
+ * @failed: number of failed tests
+ * @skipped: number of skipped tests
+ * @failures: names of failed tests in order of their completion
+ */
+struct nanotest_summary {
+    int passed;
+    int failed;
+    int skipped;
+    const char** failures;
+};
+
+/*
+ * Status of finished test is one of these letters, the same letter
+ * follows the marker written by a worker process
+ */
+#define NANOTEST_PASSED 'P'
+#define NANOTEST_FAILED 'F'
+#define NANOTEST_SKIPPED 'S'
+
+static char nanotest_status(struct nanotest_error error) {
+    if (error.message == NULL) {
+        return NANOTEST_PASSED;
+    }
+    return error.source_file == NULL ? NANOTEST_SKIPPED : NANOTEST_FAILED;
+}
+
+static const char* nanotest_status_name(char status) {
+    switch (status) {
+    case NANOTEST_PASSED:
+        return "OK";
+    case NANOTEST_SKIPPED:
+        return "SKIPPED";
+    default:
+        return "FAILED";
+    }
+}
+
+static void nanotest_print_error(struct nanotest_error error) {
+    if (error.source_file == NULL) {
+        printf("%s\n", error.message);
+    }
+    else {
+        printf("%s:%d - %s\n", error.source_file, error.line, error.message);
+    }
+}
+
+static void nanotest_summarize(
+        char status,
+        const char* name,
+        struct nanotest_summary* summary) {
+    if (status == NANOTEST_PASSED) {
+        summary->passed++;
+    }
+    else if (status == NANOTEST_SKIPPED) {
+        summary->skipped++;
+    }
+    else {
+        summary->failures[summary->failed++] = name;
+    }
+}
+
+static int nanotest_print_summary(const struct nanotest_summary* summary) {
+    int i;
+
+    printf("Passed: %d, Failed: %d, Skipped: %d\n",
+            summary->passed, summary->failed, summary->skipped);
+    for (i = 0; i < summary->failed; ++i) {
+        printf("FAILED: %s\n", summary->failures[i]);
+    }
+
+    return summary->failed;
+}
+
+#ifndef NANOTEST_RUNNER_FORK
+
+/**
+ * nanotest_run_cases() - Routine for running tests in worker processes
+ * NOTE: fallback running tests sequentially without isolation
+ */
+int nanotest_run_cases(
+        int number_of_cases,
+        const struct nanotest_case* cases,
+        const struct nanotest_runner_options* options) {
+    struct nanotest_summary summary;
+    int result;
+    int i;
+
+    (void)options;
+
+    summary.passed = 0;
+    summary.failed = 0;
+    summary.skipped = 0;
+    summary.failures = malloc(sizeof(const char*) * (size_t)number_of_cases);
+    if (number_of_cases > 0 && summary.failures == NULL) {
+        return number_of_cases;
+    }
+
+    for (i = 0; i < number_of_cases; ++i) {
+        struct nanotest_error error;
+        char status;
+        printf("Running: %s ...", cases[i].name);
+        fflush(stdout);
+        error = cases[i].test();
+        status = nanotest_status(error);
+        printf(" %s\n", nanotest_status_name(status));
+        if (status != NANOTEST_PASSED) {
+            nanotest_print_error(error);
+        }
+        nanotest_summarize(status, cases[i].name, &summary);
+    }
+
+    result = nanotest_print_summary(&summary);
+    free(summary.failures);
+    return result;
+}
+
+#else /* NANOTEST_RUNNER_FORK */
+
+/*
+ * Worker reports status of every finished test by writing this marker
+ * followed by status letter into the same pipe that captures test output,
+ * so everything preceding the marker is output of the reported test
+ */
+static const char nanotest_marker[] = "\0nanotest-status\0";
+
+#define NANOTEST_MARKER_LENGTH (sizeof(nanotest_marker) - 1)
+
+/**
+ * struct nanotest_worker - state of a forked worker process
+ * @pid: process id of the worker, 0 if slot is free
+ * @output: read end of pipe capturing stdout, stderr and status markers
+ * @batch: indexes in cases array of tests assigned to the worker
+ * @batch_length: number of tests assigned to the worker
+ * @finished: number of tests of batch already reported by the worker
+ * @started: time current test of batch was started at
+ * @timed_out: indicates that worker was killed by the runner
+ * @buffer: output captured since previous test finished
+ * @length: number of bytes in buffer
+ * @capacity: allocated size of buffer
+ */
+struct nanotest_worker {
+    pid_t pid;
+    int output;
+    int* batch;
+    int batch_length;
+    int finished;
+    double started;
+    int timed_out;
+    char* buffer;
+    size_t length;
+    size_t capacity;
+};
+
+/**
+ * struct nanotest_queue - ring of indexes of tests waiting for a worker
+ * @indexes: storage sized to hold every test at once
+ * @size: length of indexes array
+ * @head: position of the first waiting test
+ * @count: number of waiting tests
+ */
+struct nanotest_queue {
+    int* indexes;
+    int size;
+    int head;
+    int count;
+};
+
+static void nanotest_queue_push(struct nanotest_queue* queue, int index) {
+    queue->indexes[(queue->head + queue->count) % queue->size] = index;
+    queue->count++;
+}
+
+static int nanotest_queue_pop(struct nanotest_queue* queue) {
+    int index = queue->indexes[queue->head];
+    queue->head = (queue->head + 1) % queue->size;
+    queue->count--;
+    return index;
+}
+
+static double nanotest_now(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + (double)now.tv_nsec / 1e9;
+}
+
+static void nanotest_finish(
+        struct nanotest_worker* worker,
+        const char* output,
+        size_t output_length,
+        char status,
+        const char* reason,
+        const struct nanotest_case* cases,
+        struct nanotest_summary* summary) {
+    const struct nanotest_case* test_case
+        = &cases[worker->batch[worker->finished++]];
+
+    printf("Running: %s ... %s\n",
+            test_case->name, nanotest_status_name(status));
+    if (status != NANOTEST_PASSED) {
+        fwrite(output, 1, output_length, stdout);
+        if (reason != NULL) {
+            printf("%s\n", reason);
+        }
+    }
+    nanotest_summarize(status, test_case->name, summary);
+}
+
+/**
+ * nanotest_collect() - Routine for splitting captured output by markers
+ * @worker: worker which buffer is inspected
+ * @cases: pointer to array of all tests
+ * @summary: summary to put results of reported tests into
+ */
+static void nanotest_collect(
+        struct nanotest_worker* worker,
+        const struct nanotest_case* cases,
+        struct nanotest_summary* summary) {
+    size_t start = 0;
+    size_t i;
+
+    for (i = 0; i + NANOTEST_MARKER_LENGTH < worker->length; ++i) {
+        const char* marker = worker->buffer + i;
+        if (*marker == 0
+                && memcmp(marker, nanotest_marker, NANOTEST_MARKER_LENGTH) == 0
+                && worker->finished < worker->batch_length) {
+            nanotest_finish(
+                worker,
+                worker->buffer + start,
+                i - start,
+                marker[NANOTEST_MARKER_LENGTH],
+                NULL,
+                cases,
+                summary);
+            worker->started = nanotest_now();
+            i += NANOTEST_MARKER_LENGTH;
+            start = i + 1;
+        }
+    }
+
+    /* Buffer is not allocated until worker writes anything */
+    if (start > 0) {
+        memmove(worker->buffer, worker->buffer + start, worker->length - start);
+        worker->length -= start;
+    }
+}
+
+/**
+ * nanotest_capture() - Routine for reading everything worker wrote so far
+ * @worker: worker to read output of
+ *
+ * Return: 0 if worker is still running, 1 if it closed its output,
+ *         -1 if output can not be stored
+ */
+static int nanotest_capture(struct nanotest_worker* worker) {
+    char chunk[4096];
+    ssize_t length;
+
+    for (;;) {
+        length = read(worker->output, chunk, sizeof(chunk));
+        if (length > 0) {
+            size_t required = worker->length + (size_t)length;
+            if (required > worker->capacity) {
+                size_t capacity = worker->capacity * 2 + sizeof(chunk);
+                char* buffer = realloc(worker->buffer, capacity);
+                if (buffer == NULL) {
+                    /* Dropped chunk may hold status marker of a test */
+                    return -1;
+                }
+                worker->buffer = buffer;
+                worker->capacity = capacity;
+            }
+            memcpy(worker->buffer + worker->length, chunk, (size_t)length);
+            worker->length = required;
+        }
+        else if (length == 0) {
+            return 1;
+        }
+        else if (errno != EINTR) {
+            /* EAGAIN - everything written so far is captured */
+            return 0;
+        }
+    }
+}
+
+static void nanotest_work(
+        const struct nanotest_case* cases,
+        const struct nanotest_worker* worker,
+        int output) {
+    int i;
+
+    dup2(output, STDOUT_FILENO);
+    dup2(output, STDERR_FILENO);
+    /* Output printed before crash or timeout kill must not stay buffered */
+    setvbuf(stdout, NULL, _IONBF, 0);
+
+    for (i = 0; i < worker->batch_length; ++i) {
+        struct nanotest_error error = cases[worker->batch[i]].test();
+        char report[NANOTEST_MARKER_LENGTH + 1];
+        size_t written = 0;
+        ssize_t length;
+
+        memcpy(report, nanotest_marker, NANOTEST_MARKER_LENGTH);
+        report[NANOTEST_MARKER_LENGTH] = nanotest_status(error);
+        if (error.message) {
+            nanotest_print_error(error);
+        }
+
+        /* Output must reach the pipe before the marker does */
+        fflush(stdout);
+        fflush(stderr);
+        while (written < sizeof(report)) {
+            length = write(output, report + written, sizeof(report) - written);
+            if (length > 0) {
+                written += (size_t)length;
+            }
+            else if (errno != EINTR) {
+                _exit(1);
+            }
+        }
+    }
+
+    _exit(0);
+}
+
+static int nanotest_spawn(
+        struct nanotest_worker* worker,
+        const struct nanotest_case* cases,
+        struct nanotest_queue* queue,
+        int batch) {
+    int output[2];
+
+    if (pipe(output) != 0) {
+        return 1;
+    }
+
+    worker->batch_length = 0;
+    while (worker->batch_length < batch && queue->count > 0) {
+        worker->batch[worker->batch_length++] = nanotest_queue_pop(queue);
+    }
+    worker->finished = 0;
+    worker->timed_out = 0;
+    worker->length = 0;
+
+    /* Pending output would be flushed twice otherwise */
+    fflush(stdout);
+    fflush(stderr);
+
+    worker->pid = fork();
+    if (worker->pid == 0) {
+        close(output[0]);
+        nanotest_work(cases, worker, output[1]);
+    }
+
+    close(output[1]);
+
+    if (worker->pid < 0) {
+        close(output[0]);
+        worker->pid = 0;
+        while (worker->batch_length > 0) {
+            nanotest_queue_push(queue, worker->batch[--worker->batch_length]);
+        }
+        return 1;
+    }
+
+    fcntl(output[0], F_SETFL, fcntl(output[0], F_GETFL) | O_NONBLOCK);
+    worker->output = output[0];
+    worker->started = nanotest_now();
+    return 0;
+}
+
+static void nanotest_reap(
+        struct nanotest_worker* worker,
+        const struct nanotest_case* cases,
+        struct nanotest_queue* queue,
+        int timeout,
+        struct nanotest_summary* summary) {
+    int status;
+    char reason[64];
+
+    while (waitpid(worker->pid, &status, 0) < 0 && errno == EINTR) {
+    }
+
+    if (worker->finished < worker->batch_length) {
+        if (worker->timed_out) {
+            sprintf(reason, "Timed out after %d s", timeout);
+        }
+        else if (WIFSIGNALED(status)) {
+            sprintf(reason, "Terminated by signal %d", WTERMSIG(status));
+        }
+        else {
+            sprintf(reason, "Exited with status %d", WEXITSTATUS(status));
+        }
+        nanotest_finish(
+            worker,
+            worker->buffer,
+            worker->length,
+            NANOTEST_FAILED,
+            reason,
+            cases,
+            summary);
+
+        /* The rest of the batch deserves another chance */
+        while (worker->finished < worker->batch_length) {
+            nanotest_queue_push(queue, worker->batch[worker->finished++]);
+        }
+    }
+
+    close(worker->output);
+    worker->pid = 0;
+}
+
+static int nanotest_online_processors(void) {
+#ifdef _SC_NPROCESSORS_ONLN
+    long processors = sysconf(_SC_NPROCESSORS_ONLN);
+    if (processors > 0) {
+        return (int)processors;
+    }
+#endif
+    return 1;
+}
+
+/**
+ * nanotest_run_cases() - Routine for running tests in worker processes
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_run_cases(
+        int number_of_cases,
+        const struct nanotest_case* cases,
+        const struct nanotest_runner_options* options) {
+    struct nanotest_summary summary;
+    struct nanotest_queue queue;
+    struct nanotest_worker* workers;
+    struct pollfd* fds;
+    int jobs = 0;
+    int batch = 1;
+    int timeout = 0;
+    int result;
+    int i;
+
+    if (number_of_cases <= 0) {
+        printf("Passed: 0, Failed: 0, Skipped: 0\n");
+        return 0;
+    }
+
+    if (options != NULL) {
+        jobs = options->jobs;
+        batch = options->batch > 0 ? options->batch : 1;
+        timeout = options->timeout;
+    }
+    if (jobs <= 0) {
+        jobs = nanotest_online_processors();
+    }
+    if (jobs > number_of_cases) {
+        jobs = number_of_cases;
+    }
+
+    summary.passed = 0;
+    summary.failed = 0;
+    summary.skipped = 0;
+    summary.failures = malloc(sizeof(const char*) * (size_t)number_of_cases);
+    queue.indexes = malloc(sizeof(int) * (size_t)number_of_cases);
+    queue.size = number_of_cases;
+    queue.head = 0;
+    queue.count = 0;
+    workers = calloc((size_t)jobs, sizeof(struct nanotest_worker));
+    fds = malloc(sizeof(struct pollfd) * (size_t)jobs);
+    for (i = 0; workers != NULL && i < jobs; ++i) {
+        workers[i].batch = malloc(sizeof(int) * (size_t)batch);
+        if (workers[i].batch == NULL) {
+            jobs = i;
+        }
+    }
+
+    if (summary.failures == NULL || queue.indexes == NULL
+            || workers == NULL || fds == NULL || jobs == 0) {
+        fprintf(stderr, "nanotest: out of memory\n");
+        result = number_of_cases;
+        goto cleanup;
+    }
+
+    for (i = 0; i < number_of_cases; ++i) {
+        nanotest_queue_push(&queue, i);
+    }
+
+    while (summary.passed + summary.failed + summary.skipped
+            < number_of_cases) {
+        int number_of_fds = 0;
+        int wait = -1;
+        double now;
+
+        for (i = 0; i < jobs && queue.count > 0; ++i) {
+            if (workers[i].pid == 0
+                    && nanotest_spawn(&workers[i], cases, &queue, batch) != 0) {
+                /* Retry once some of running workers finish */
+                break;
+            }
+        }
+
+        now = nanotest_now();
+        for (i = 0; i < jobs; ++i) {
+            if (workers[i].pid == 0) {
+                continue;
+            }
+            fds[number_of_fds].fd = workers[i].output;
+            fds[number_of_fds].events = POLLIN;
+            fds[number_of_fds].revents = 0;
+            ++number_of_fds;
+            if (timeout > 0) {
+                double left = workers[i].started + timeout - now;
+                int left_ms = left > 0 ? (int)(left * 1000) + 1 : 0;
+                if (wait < 0 || left_ms < wait) {
+                    wait = left_ms;
+                }
+            }
+        }
+
+        if (number_of_fds == 0) {
+            fprintf(stderr, "nanotest: unable to start worker\n");
+            result = number_of_cases;
+            goto cleanup;
+        }
+
+        if (poll(fds, (nfds_t)number_of_fds, wait) < 0 && errno != EINTR) {
+            perror("nanotest: poll");
+            result = number_of_cases;
+            goto cleanup;
+        }
+
+        now = nanotest_now();
+        for (i = 0; i < jobs; ++i) {
+            int closed;
+            if (workers[i].pid == 0) {
+                continue;
+            }
+            closed = nanotest_capture(&workers[i]);
+            if (closed < 0) {
+                fprintf(stderr, "nanotest: out of memory\n");
+                result = number_of_cases;
+                goto cleanup;
+            }
+            nanotest_collect(&workers[i], cases, &summary);
+            if (closed) {
+                nanotest_reap(&workers[i], cases, &queue, timeout, &summary);
+            }
+            else if (timeout > 0 && !workers[i].timed_out
+                    && now - workers[i].started >= timeout) {
+                kill(workers[i].pid, SIGKILL);
+                workers[i].timed_out = 1;
+            }
+        }
+    }
+
+    result = nanotest_print_summary(&summary);
+
+cleanup:
+    for (i = 0; workers != NULL && i < jobs; ++i) {
+        if (workers[i].pid != 0) {
+            kill(workers[i].pid, SIGKILL);
+            waitpid(workers[i].pid, NULL, 0);
+            close(workers[i].output);
+        }
+        free(workers[i].batch);
+        free(workers[i].buffer);
+    }
+    free(fds);
+    free(workers);
+    free(queue.indexes);
+    free(summary.failures);
+    return result;
+}
+
+#endif /* NANOTEST_RUNNER_FORK */
+
+/**
+ * struct nanotest_registry - table of tests registered by nanotest_test()
+ * @cases: registered tests in order of registration
+ * @length: number of registered tests
+ * @capacity: allocated length of cases array
+ * @broken: indicates that some test was lost due to lack of memory
+ */
+static struct nanotest_registry {
+    struct nanotest_case* cases;
+    int length;
+    int capacity;
+    int broken;
+} nanotest_registry = { NULL, 0, 0, 0 };
+
+/**
+ * nanotest_register() - Routine for adding test to the global registry
+ * NOTE: description of function arguments available in header file
+ */
+void nanotest_register(
+        const char* name,
+        struct nanotest_error (*test)(void)) {
+    if (nanotest_registry.length == nanotest_registry.capacity) {
+        int capacity = nanotest_registry.capacity * 2 + 64;
+        struct nanotest_case* cases = realloc(
+            nanotest_registry.cases,
+            sizeof(struct nanotest_case) * (size_t)capacity);
+        if (cases == NULL) {
+            nanotest_registry.broken = 1;
+            return;
+        }
+        nanotest_registry.cases = cases;
+        nanotest_registry.capacity = capacity;
+    }
+
+    nanotest_registry.cases[nanotest_registry.length].name = name;
+    nanotest_registry.cases[nanotest_registry.length].test = test;
+    nanotest_registry.length++;
+}
+
+static int nanotest_compare_names(const void* left, const void* right) {
+    return strcmp(
+        ((const struct nanotest_case*)left)->name,
+        ((const struct nanotest_case*)right)->name);
+}
+
+/**
+ * nanotest_match() - Routine for matching test name against filter
+ * @pattern: filter where '*' matches any string and '?' any character
+ * @name: name of the test
+ *
+ * Return: 1 if name matches pattern, 0 otherwise
+ */
+static int nanotest_match(const char* pattern, const char* name) {
+    for (; *pattern != '*'; ++pattern, ++name) {
+        if (*name == 0) {
+            return *pattern == 0;
+        }
+        if (*pattern != '?' && *pattern != *name) {
+            return 0;
+        }
+    }
+
+    for (; *name != 0; ++name) {
+        if (nanotest_match(pattern + 1, name)) {
+            return 1;
+        }
+    }
+
+    return nanotest_match(pattern + 1, name);
+}
+
+static int nanotest_parse_number(const char* string, int* number) {
+    char* end;
+    long value;
+
+    if (string == NULL) {
+        return 1;
+    }
+    value = strtol(string, &end, 10);
+    if (end == string || *end != 0 || value < 0 || value > 1000000) {
+        return 1;
+    }
+
+    *number = (int)value;
+    return 0;
+}
+
+static int nanotest_parse_shard(const char* string, int* index, int* count) {
+    const char* slash;
+    char index_string[16];
+
+    if (string == NULL) {
+        return 1;
+    }
+    slash = strchr(string, '/');
+    if (slash == NULL || (size_t)(slash - string) >= sizeof(index_string)) {
+        return 1;
+    }
+    memcpy(index_string, string, (size_t)(slash - string));
+    index_string[slash - string] = 0;
+
+    if (nanotest_parse_number(index_string, index) != 0
+            || nanotest_parse_number(slash + 1, count) != 0
+            || *index < 1 || *index > *count) {
+        return 1;
+    }
+
+    return 0;
+}
+
+/**
+ * nanotest_options - options accepted by nanotest_main()
+ */
+static const struct clap_option nanotest_options[] = {
+    { 'h', "help", CLAP_NO_VALUE, "prints help" },
+    { 'l', "list", CLAP_NO_VALUE, "lists selected tests and exits" },
+    { 'j', "jobs", CLAP_VALUE_REQUIRED, "number of worker processes" },
+    { 'b', "batch", CLAP_VALUE_REQUIRED, "number of tests per worker" },
+    { 't', "timeout", CLAP_VALUE_REQUIRED, "seconds single test may run" },
+    { 's', "shard", CLAP_VALUE_REQUIRED, "runs only i-th of n shards (i/n)" }
+};
+
+enum {
+    NANOTEST_HELP,
+    NANOTEST_LIST,
+    NANOTEST_JOBS,
+    NANOTEST_BATCH,
+    NANOTEST_TIMEOUT,
+    NANOTEST_SHARD,
+    NANOTEST_NUMBER_OF_OPTIONS
+};
+
+/**
+ * nanotest_find_unknown_option() - Routine for finding mistyped options
+ * @argc: main argc corresponding argument
+ * @argv: main argv corresponding argument
+ *
+ * clap ignores options it does not know, so mistyped --shard would run
+ * the whole suite. Values in the next argument never start with '-', so
+ * every argument starting with '-' before "--" is an option.
+ *
+ * Return: index of the first unknown option, 0 if there are none
+ */
+static int nanotest_find_unknown_option(int argc, char* argv[]) {
+    int i;
+    int j;
+
+    for (i = 1; i < argc && strcmp(argv[i], "--") != 0; ++i) {
+        const char* arg = argv[i];
+        int known = 1;
+
+        if (arg[0] != '-' || arg[1] == 0) {
+            continue;
+        }
+
+        if (arg[1] == '-') {
+            size_t length = strcspn(arg + 2, "=");
+            known = 0;
+            for (j = 0; j < NANOTEST_NUMBER_OF_OPTIONS; ++j) {
+                const char* word = nanotest_options[j].word;
+                if (word != NULL && strlen(word) == length
+                        && strncmp(word, arg + 2, length) == 0) {
+                    known = 1;
+                }
+            }
+        }
+        else {
+            /* Grouped letters end with the first one taking value */
+            for (++arg; *arg != 0 && known; ++arg) {
+                for (j = 0; j < NANOTEST_NUMBER_OF_OPTIONS
+                        && nanotest_options[j].letter != *arg; ++j) {
+                }
+                if (j == NANOTEST_NUMBER_OF_OPTIONS) {
+                    known = 0;
+                }
+                else if (nanotest_options[j].value_required != CLAP_NO_VALUE) {
+                    break;
+                }
+            }
+        }
+
+        if (!known) {
+            return i;
+        }
+    }
+
+    return 0;
+}
+
+/**
+ * nanotest_main() - Routine for running registered tests as main() does
+ * NOTE: description of function arguments available in header file
+ */
+int nanotest_main(int argc, char* argv[]) {
+    static const char* free_args_names[] = { "filters", NULL };
+    struct clap_value values[NANOTEST_NUMBER_OF_OPTIONS];
+    struct nanotest_runner_options options = { 0, 1, 0 };
+    struct nanotest_case* selected = NULL;
+    int* free_args;
+    int number_of_selected = 0;
+    int number_of_matched = 0;
+    int number_of_filters = 0;
+    int unknown_option;
+    int shard_index = 1;
+    int shard_count = 1;
+    int result = 1;
+    int i;
+    int j;
+
+    memset(values, 0, sizeof(values));
+
+    if (nanotest_registry.broken) {
+        fprintf(stderr, "nanotest: out of memory during registration\n");
+        return 1;
+    }
+
+    free_args = malloc(sizeof(int) * ((size_t)argc + 1));
+    if (free_args == NULL
+            || (nanotest_registry.length > 0 && (selected = malloc(
+                sizeof(struct nanotest_case)
+                * (size_t)nanotest_registry.length)) == NULL)) {
+        fprintf(stderr, "nanotest: out of memory\n");
+        goto cleanup;
+    }
+
+    unknown_option = nanotest_find_unknown_option(argc, argv);
+    if (unknown_option != 0) {
+        fprintf(stderr, "nanotest: unknown option %s\n", argv[unknown_option]);
+    }
+
+    if (unknown_option != 0
+            || clap_parse(
+                argc,
+                (const char**)argv,
+                NANOTEST_NUMBER_OF_OPTIONS,
+                nanotest_options,
+                values,
+                free_args) != 0
+            || (values[NANOTEST_JOBS].enabled && nanotest_parse_number(
+                values[NANOTEST_JOBS].string, &options.jobs) != 0)
+            || (values[NANOTEST_BATCH].enabled && nanotest_parse_number(
+                values[NANOTEST_BATCH].string, &options.batch) != 0)
+            || (values[NANOTEST_TIMEOUT].enabled && nanotest_parse_number(
+                values[NANOTEST_TIMEOUT].string, &options.timeout) != 0)
+            || (values[NANOTEST_SHARD].enabled && nanotest_parse_shard(
+                values[NANOTEST_SHARD].string,
+                &shard_index,
+                &shard_count) != 0)
+            || values[NANOTEST_HELP].enabled) {
+        clap_print_help(
+            values[NANOTEST_HELP].enabled ? stdout : stderr,
+            argv[0],
+            2,
+            free_args_names,
+            NANOTEST_NUMBER_OF_OPTIONS,
+            nanotest_options);
+        result = !values[NANOTEST_HELP].enabled;
+        goto cleanup;
+    }
+
+    for (j = 0; free_args[j] != -1; ++j) {
+        if (free_args[j] != 0) {
+            ++number_of_filters;
+        }
+    }
+
+    qsort(
+        nanotest_registry.cases,
+        (size_t)nanotest_registry.length,
+        sizeof(struct nanotest_case),
+        nanotest_compare_names);
+
+    for (i = 0; i < nanotest_registry.length; ++i) {
+        const struct nanotest_case* test_case = &nanotest_registry.cases[i];
+        int matched = 1;
+
+        /* The first free argument is program name itself */
+        for (j = 0; free_args[j] != -1; ++j) {
+            if (free_args[j] == 0) {
+                continue;
+            }
+            matched = nanotest_match(argv[free_args[j]], test_case->name);
+            if (matched) {
+                break;
+            }
+        }
+
+        if (matched && number_of_matched++ % shard_count == shard_index - 1) {
+            selected[number_of_selected++] = *test_case;
+        }
+    }
+
+    /* Mistyped filter must not pass as a successful run of nothing */
+    if (number_of_filters > 0 && number_of_matched == 0) {
+        if (!values[NANOTEST_LIST].enabled) {
+            nanotest_run_cases(0, selected, &options);
+        }
+        fprintf(stderr, "nanotest: no tests match given filters\n");
+        goto cleanup;
+    }
+
+    if (values[NANOTEST_LIST].enabled) {
+        for (i = 0; i < number_of_selected; ++i) {
+            printf("%s\n", selected[i].name);
+        }
+        result = 0;
+        goto cleanup;
+    }
+
+    result = nanotest_run_cases(number_of_selected, selected, &options) != 0;
+
+cleanup:
+    free(selected);
+    free(free_args);
+    return result;
+}
@@ -0,0 +1,114 @@
+#ifndef NANOTEST_RUNNER_H
+#define NANOTEST_RUNNER_H
+
+#include "nanotest.h"
+
+/**
+ * struct nanotest_case - named test function
+ * @name: name of the test printed in reports
+ * @test: test function returning nanotest_error
+ */
+struct nanotest_case {
+    const char* name;
+    struct nanotest_error (*test)(void);
+};
+
+/* Initializer of struct nanotest_case named after test function itself */
+#define nanotest_case(test) { #test, test }
+
+/**
+ * struct nanotest_runner_options - tunables of nanotest_run_cases()
+ * @jobs: maximum number of worker processes running simultaneously
+ *        0 means number of online processors
+ * @batch: number of tests run one after another by a single worker process
+ *         0 means 1, so every test is isolated in its own process
+ * @timeout: seconds single test may run before its worker is killed
+ *           0 means no limit
+ */
+struct nanotest_runner_options {
+    int jobs;
+    int batch;
+    int timeout;
+};
+
+/**
+ * nanotest_run_cases() - Routine for running tests in worker processes
+ * @number_of_cases: length of cases array
+ * @cases: pointer to array of tests to run
+ * @options: runner tunables, null pointer selects defaults
+ *
+ * Every worker is forked from the calling process, its stdout and stderr
+ * are captured and printed only for failed tests. Test that crashes,
+ * calls exit() or exceeds timeout is reported as failed, remaining tests
+ * of its batch are rescheduled to another worker.
+ * On platforms without fork() tests are run sequentially in process.
+ *
+ * Return: number of failed tests, 0 if everything was successful
+ */
+int nanotest_run_cases(
+    int number_of_cases,
+    const struct nanotest_case* cases,
+    const struct nanotest_runner_options* options);
+
+/**
+ * nanotest_register() - Routine for adding test to the global registry
+ * @name: name of the test
+ * @test: test function
+ *
+ * Usually called by nanotest_test() before main() is entered
+ */
+void nanotest_register(
+    const char* name,
+    struct nanotest_error (*test)(void));
+
+/**
+ * nanotest_main() - Routine for running registered tests as main() does
+ * @argc: main argc corresponding argument
+ * @argv: main argv corresponding argument
+ *
+ * Free arguments are name filters with '*' and '?' wildcards,
+ * test is selected if it matches any of them or if there are no filters.
+ * Selected tests are ordered by name, so --shard=i/n (1 <= i <= n)
+ * picks the same tests on every machine running the same binary.
+ * Run with --help for description of all options.
+ *
+ * Return: 0 if every selected test passed, 1 otherwise or if filters
+ *         were given but none of tests matched them
+ */
+int nanotest_main(int argc, char* argv[]);
+
+/*
+ * Test function definition registering itself before main() is entered:
+ *     nanotest_test(your_test) {
+ *         nanotest_success();
+ *     }
+ */
+#define nanotest_test(name)\
+    static struct nanotest_error name(void);\
+    NANOTEST_CONSTRUCTOR(name##_register) {\
+        nanotest_register(#name, name);\
+    }\
+    static struct nanotest_error name(void)
+
+#if defined(__GNUC__)
+#define NANOTEST_CONSTRUCTOR(function)\
+    static void function(void) __attribute__((constructor));\
+    static void function(void)
+#elif defined(_MSC_VER)
+#pragma section(".CRT$XCU", read)
+#if defined(_WIN64)
+#define NANOTEST_SYMBOL_PREFIX ""
+#else
+#define NANOTEST_SYMBOL_PREFIX "_"
+#endif
+/* Pointer placed into C initializers section is called by CRT */
+#define NANOTEST_CONSTRUCTOR(function)\
+    static void function(void);\
+    __declspec(allocate(".CRT$XCU")) void (*function##_pointer)(void)\
+        = function;\
+    __pragma(comment(linker,\
+        "/include:" NANOTEST_SYMBOL_PREFIX #function "_pointer"))\
+    static void function(void)
+#endif
+
+#endif /* NANOTEST_RUNNER_H */
@@ -0,0 +1,105 @@
+#define _POSIX_C_SOURCE 200112L
+
+#include "nanotest_runner.h"
+
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+
+#define LENGTH(array) (sizeof(array) / sizeof(0[array]))
+
+struct nanotest_error runner_pass_test() {
+    printf("output of passed test is not printed\n");
+    nanotest_success();
+}
+
+struct nanotest_error runner_fail_test() {
+    printf("output of failed test is printed\n");
+    nanotest_assert(1 + 1 == 3, "1 + 1 != 3");
+    nanotest_success();
+}
+
+struct nanotest_error runner_skip_test() {
+    nanotest_skip("skipped test is not failed");
+}
+
+struct nanotest_error runner_crash_test() {
+    printf("output printed before crash\n");
+    raise(SIGSEGV);
+    nanotest_success();
+}
+
+struct nanotest_error runner_exit_test() {
+    exit(1);
+}
+
+struct nanotest_error runner_hang_test() {
+    volatile int forever = 1;
+    printf("output printed before timeout\n");
+    while (forever) {
+    }
+    nanotest_success();
+}
+
+int main() {
+    static const struct nanotest_case cases[] = {
+        nanotest_case(runner_pass_test),
+        nanotest_case(runner_crash_test),
+        nanotest_case(runner_pass_test),
+        nanotest_case(runner_exit_test),
+        nanotest_case(runner_pass_test),
+        nanotest_case(runner_fail_test),
+        nanotest_case(runner_skip_test),
+        nanotest_case(runner_hang_test),
+        nanotest_case(runner_pass_test)
+    };
+    static const char* expected_outputs[] = {
+        "output of failed test is printed",
+        "output printed before crash",
+        "output printed before timeout",
+        "Running: runner_skip_test ... SKIPPED\nskipped test is not failed",
+        "Passed: 4, Failed: 4, Skipped: 1"
+    };
+    struct nanotest_runner_options options;
+    FILE* log = tmpfile();
+    char output[4096];
+    size_t length;
+    int standard_output;
+    int failed;
+    int result = 0;
+    size_t i;
+
+    if (log == NULL) {
+        perror("tmpfile");
+        return 1;
+    }
+
+    options.jobs = 3;
+    options.batch = 2;
+    options.timeout = 1;
+
+    /* Report of the runner is captured to check output of failed tests */
+    fflush(stdout);
+    standard_output = dup(STDOUT_FILENO);
+    dup2(fileno(log), STDOUT_FILENO);
+    failed = nanotest_run_cases(LENGTH(cases), cases, &options);
+    fflush(stdout);
+    dup2(standard_output, STDOUT_FILENO);
+    close(standard_output);
+
+    rewind(log);
+    length = fread(output, 1, sizeof(output) - 1, log);
+    output[length] = 0;
+    fclose(log);
+    fwrite(output, 1, length, stdout);
+
+    for (i = 0; i < LENGTH(expected_outputs); ++i) {
+        if (strstr(output, expected_outputs[i]) == NULL) {
+            printf("Missing output: %s\n", expected_outputs[i]);
+            result = 1;
+        }
+    }
+
+    printf("Expected 4 failed tests, got %d\n", failed);
+    return failed == 4 ? result : 1;
+}
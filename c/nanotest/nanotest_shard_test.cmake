@@ -0,0 +1,47 @@
+# Checks that shards of nanotest executable select every test exactly once
+#
+# Options (should be passed before -P):
+#   -DEXECUTABLE=path - test executable using nanotest_main()
+#   -DSHARDS=n        - number of shards to split tests into
+
+cmake_minimum_required(VERSION 3.0)
+
+# Runs EXECUTABLE --list with ARGN arguments and sets OUTPUT to listed tests
+function(nanotest_list OUTPUT)
+    execute_process(
+        COMMAND "${EXECUTABLE}" --list ${ARGN}
+        RESULT_VARIABLE RESULT
+        OUTPUT_VARIABLE LIST
+        )
+    if (NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "${EXECUTABLE} --list ${ARGN} failed with ${RESULT}")
+    endif()
+    set(${OUTPUT} "${LIST}" PARENT_SCOPE)
+endfunction()
+
+nanotest_list(ALL_TESTS)
+if ("${ALL_TESTS}" STREQUAL "")
+    message(FATAL_ERROR "${EXECUTABLE} has no tests")
+endif()
+
+set(SHARDED_TESTS "")
+foreach(SHARD RANGE 1 ${SHARDS})
+    nanotest_list(SHARD_TESTS --shard=${SHARD}/${SHARDS})
+    set(SHARDED_TESTS "${SHARDED_TESTS}${SHARD_TESTS}")
+endforeach()
+
+# Shards are picked from tests ordered by name, so both lists are sorted
+foreach(LIST ALL_TESTS SHARDED_TESTS)
+    string(STRIP "${${LIST}}" ${LIST})
+    string(REPLACE "\n" ";" ${LIST} "${${LIST}}")
+    list(SORT ${LIST})
+endforeach()
+
+if (NOT "${ALL_TESTS}" STREQUAL "${SHARDED_TESTS}")
+    message(
+        FATAL_ERROR
+        "Shards do not cover tests exactly once:\n"
+        "all: ${ALL_TESTS}\n"
+        "sharded: ${SHARDED_TESTS}"
+        )
+endif()
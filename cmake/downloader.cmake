@@ -1,39 +1,308 @@
 #!/usr/bin/env cmake -P
 
 # File downloader script
-# All pairs of argument will be used as source and destination
+# Arguments are entries of URL, destination path and optional
+# SHA256=<hex> expected hash of the file
+#
+# Options (should be passed before -P):
+#   -DDOWNLOADER_JOBS=N    - maximum number of simultaneous downloads,
+#                            1 (sequential downloads) by default
+#   -DDOWNLOADER_CACHE=dir - directory of files shared between builds,
+#                            files with expected hash are kept there
+#                            as dir/sha256/<hex> and linked to destination
+#                            (copied before CMake 3.14)
+#
+# Entry with expected hash is not downloaded if destination or cache
+# already contains the file with that hash
+#
+# Script fails if any of downloads failed
 
-math(EXPR NUMBER_OF_ARGUMENTS "${CMAKE_ARGC} - 3")
-math(EXPR NUMBER_OF_ARGUMENTS_PARITY "${NUMBER_OF_ARGUMENTS} % 2")
+cmake_minimum_required(VERSION 3.10)
 
-if (${NUMBER_OF_ARGUMENTS_PARITY} EQUAL 1)
-    message(
-        FATAL_ERROR
-        "Number of arguments (${NUMBER_OF_ARGUMENTS}) is not even"
-        )
-endif()
+# Links or copies cached file SOURCE to PATH and sets RESULT
+# to empty string on success or to the reason of failure otherwise
+function(downloader_link SOURCE PATH RESULT)
+    get_filename_component(DIRECTORY "${PATH}" DIRECTORY)
+    file(MAKE_DIRECTORY "${DIRECTORY}")
+    if (CMAKE_VERSION VERSION_LESS 3.14)
+        # file(CREATE_LINK) appeared in CMake 3.14 only
+        execute_process(
+            COMMAND "${CMAKE_COMMAND}" -E copy "${SOURCE}" "${PATH}"
+            RESULT_VARIABLE LINK_RESULT
+            )
+    else()
+        file(
+            CREATE_LINK
+                "${SOURCE}"
+                "${PATH}"
+            RESULT
+                LINK_RESULT
+            COPY_ON_ERROR
+            )
+    endif()
+
+    if (NOT "${LINK_RESULT}" STREQUAL "0")
+        set(${RESULT} "failed to link ${SOURCE}: ${LINK_RESULT}" PARENT_SCOPE)
+    else()
+        set(${RESULT} "" PARENT_SCOPE)
+    endif()
+endfunction()
 
-math(EXPR BORDER "${CMAKE_ARGC} - 1")
+# Downloads URL to PATH and sets RESULT to empty string on success
+# or to the reason of failure otherwise, HASH is expected SHA256
+# of the file or "-" if it is not known
+function(downloader_fetch URL PATH HASH RESULT)
+    set(TARGET "${PATH}")
+    set(CACHE_PATH "")
+    if (NOT "${HASH}" STREQUAL "-")
+        if (EXISTS "${PATH}")
+            file(SHA256 "${PATH}" PATH_HASH)
+            if ("${PATH_HASH}" STREQUAL "${HASH}")
+                message("Skipping ${URL}, ${PATH} is up to date")
+                set(${RESULT} "" PARENT_SCOPE)
+                return()
+            endif()
+        endif()
 
-foreach(URL_INDEX RANGE 3 ${BORDER} 2)
-    math(EXPR PATH_INDEX "${URL_INDEX} + 1")
-    set(URL "${CMAKE_ARGV${URL_INDEX}}")
-    set(PATH "${CMAKE_ARGV${PATH_INDEX}}")
+        if (DEFINED DOWNLOADER_CACHE)
+            set(CACHE_PATH "${DOWNLOADER_CACHE}/sha256/${HASH}")
+            set(TARGET "${CACHE_PATH}")
+            if (EXISTS "${CACHE_PATH}")
+                file(SHA256 "${CACHE_PATH}" CACHE_HASH)
+                if ("${CACHE_HASH}" STREQUAL "${HASH}")
+                    message("Linking ${CACHE_PATH} to ${PATH}")
+                    downloader_link("${CACHE_PATH}" "${PATH}" LINK_RESULT)
+                    set(${RESULT} "${LINK_RESULT}" PARENT_SCOPE)
+                    return()
+                endif()
+
+                message("Removing corrupted ${CACHE_PATH}")
+                file(REMOVE "${CACHE_PATH}")
+            endif()
+        endif()
+    endif()
+
+    # File is moved to its place only after it is verified,
+    # so concurrent builds never see partial or unverified content
+    string(RANDOM LENGTH 8 TEMPORARY_SUFFIX)
+    set(TEMPORARY "${TARGET}.part-${TEMPORARY_SUFFIX}")
 
     message("Downloading ${URL} to ${PATH}")
 
     file(
         DOWNLOAD
             "${URL}"
-            "${PATH}"
+            "${TEMPORARY}"
         STATUS
             DOWNLOAD_STATUS
         )
 
     list(GET DOWNLOAD_STATUS 0 DOWNLOAD_CODE)
     list(GET DOWNLOAD_STATUS 1 DOWNLOAD_MESSAGE)
+    set(FAILURE "")
     if (NOT ${DOWNLOAD_CODE} EQUAL 0)
-        message("Failed with code ${DOWNLOAD_CODE}: ${DOWNLOAD_MESSAGE}")
+        set(FAILURE "failed with code ${DOWNLOAD_CODE}: ${DOWNLOAD_MESSAGE}")
+    elseif (NOT "${HASH}" STREQUAL "-")
+        file(SHA256 "${TEMPORARY}" DOWNLOAD_HASH)
+        if (NOT "${DOWNLOAD_HASH}" STREQUAL "${HASH}")
+            set(FAILURE "failed: SHA256 is ${DOWNLOAD_HASH} instead of ${HASH}")
+        endif()
+    endif()
+
+    if (NOT "${FAILURE}" STREQUAL "")
+        # Do not leave any file to be mistaken for downloaded one
+        file(REMOVE "${TEMPORARY}" "${PATH}")
+        set(${RESULT} "${FAILURE}" PARENT_SCOPE)
+        return()
     endif()
 
+    file(RENAME "${TEMPORARY}" "${TARGET}")
+    if (NOT "${CACHE_PATH}" STREQUAL "")
+        downloader_link("${CACHE_PATH}" "${PATH}" LINK_RESULT)
+        set(${RESULT} "${LINK_RESULT}" PARENT_SCOPE)
+    else()
+        set(${RESULT} "" PARENT_SCOPE)
+    endif()
+endfunction()
+
+if (DEFINED DOWNLOADER_QUEUE)
+    # Worker mode: claim entries of the queue one by one until none left
+    # file(STRINGS) would split lines on non-ASCII characters
+    foreach(LIST URLS PATHS HASHES)
+        string(TOLOWER ${LIST} LIST_FILE)
+        file(READ "${DOWNLOADER_QUEUE}/${LIST_FILE}" ${LIST})
+        string(REPLACE "\n" ";" ${LIST} "${${LIST}}")
+    endforeach()
+    list(LENGTH URLS NUMBER_OF_ENTRIES)
+
+    while(TRUE)
+        file(LOCK "${DOWNLOADER_QUEUE}/lock")
+        file(READ "${DOWNLOADER_QUEUE}/next" INDEX)
+        math(EXPR NEXT_INDEX "${INDEX} + 1")
+        file(WRITE "${DOWNLOADER_QUEUE}/next" "${NEXT_INDEX}")
+        file(LOCK "${DOWNLOADER_QUEUE}/lock" RELEASE)
+
+        if (NOT ${INDEX} LESS ${NUMBER_OF_ENTRIES})
+            break()
+        endif()
+
+        list(GET URLS ${INDEX} URL)
+        list(GET PATHS ${INDEX} PATH)
+        list(GET HASHES ${INDEX} HASH)
+        downloader_fetch("${URL}" "${PATH}" "${HASH}" RESULT)
+        file(WRITE "${DOWNLOADER_QUEUE}/status-${INDEX}" "${RESULT}")
+    endwhile()
+
+    return()
+endif()
+
+# Arguments of the script follow its path which follows -P
+set(FIRST_ARGUMENT 0)
+math(EXPR LAST_ARGUMENT "${CMAKE_ARGC} - 1")
+foreach(ARGUMENT_INDEX RANGE 1 ${LAST_ARGUMENT})
+    if ("${CMAKE_ARGV${ARGUMENT_INDEX}}" STREQUAL "-P")
+        math(EXPR FIRST_ARGUMENT "${ARGUMENT_INDEX} + 2")
+        break()
+    endif()
 endforeach()
+
+# Every entry is URL, PATH and optional SHA256=<hex>,
+# "-" is kept in HASHES for entries without expected hash
+set(URLS)
+set(PATHS)
+set(HASHES)
+set(ARGUMENT_INDEX ${FIRST_ARGUMENT})
+while (${ARGUMENT_INDEX} LESS ${CMAKE_ARGC})
+    set(URL "${CMAKE_ARGV${ARGUMENT_INDEX}}")
+    math(EXPR ARGUMENT_INDEX "${ARGUMENT_INDEX} + 1")
+    if (NOT ${ARGUMENT_INDEX} LESS ${CMAKE_ARGC})
+        message(FATAL_ERROR "No destination path for ${URL}")
+    endif()
+
+    # Entries are kept in lists and passed to workers line by line
+    if ("${URL}${CMAKE_ARGV${ARGUMENT_INDEX}}" MATCHES "[;\n]")
+        message(
+            FATAL_ERROR
+            "Semicolons and new lines are not supported in URLs and paths "
+            "(use %3B and %0A in URLs): ${URL}"
+            )
+    endif()
+
+    list(APPEND URLS "${URL}")
+    get_filename_component(
+        PATH
+        "${CMAKE_ARGV${ARGUMENT_INDEX}}"
+        ABSOLUTE
+        )
+    list(APPEND PATHS "${PATH}")
+    math(EXPR ARGUMENT_INDEX "${ARGUMENT_INDEX} + 1")
+
+    set(HASH "-")
+    if ("${CMAKE_ARGV${ARGUMENT_INDEX}}" MATCHES "^SHA256=(.*)$"
+            AND ${ARGUMENT_INDEX} LESS ${CMAKE_ARGC})
+        string(TOLOWER "${CMAKE_MATCH_1}" HASH)
+        string(LENGTH "${HASH}" HASH_LENGTH)
+        if (NOT HASH MATCHES "^[0-9a-f]+$" OR NOT ${HASH_LENGTH} EQUAL 64)
+            message(FATAL_ERROR "Malformed SHA256 for ${URL}: ${HASH}")
+        endif()
+        math(EXPR ARGUMENT_INDEX "${ARGUMENT_INDEX} + 1")
+    endif()
+    list(APPEND HASHES "${HASH}")
+endwhile()
+
+list(LENGTH URLS NUMBER_OF_ENTRIES)
+if (${NUMBER_OF_ENTRIES} EQUAL 0)
+    return()
+endif()
+math(EXPR LAST_ENTRY "${NUMBER_OF_ENTRIES} - 1")
+
+if (DEFINED DOWNLOADER_CACHE)
+    get_filename_component(DOWNLOADER_CACHE "${DOWNLOADER_CACHE}" ABSOLUTE)
+endif()
+
+if (NOT DEFINED DOWNLOADER_JOBS)
+    set(DOWNLOADER_JOBS 1)
+endif()
+if (NOT DOWNLOADER_JOBS MATCHES "^[1-9][0-9]*$")
+    message(
+        FATAL_ERROR
+        "DOWNLOADER_JOBS (${DOWNLOADER_JOBS}) is not a positive number"
+        )
+endif()
+if (${DOWNLOADER_JOBS} GREATER ${NUMBER_OF_ENTRIES})
+    set(DOWNLOADER_JOBS ${NUMBER_OF_ENTRIES})
+endif()
+
+# Reason of failure of entry INDEX is kept in FAILURE_${INDEX} variable
+if (${DOWNLOADER_JOBS} EQUAL 1)
+    foreach(INDEX RANGE ${LAST_ENTRY})
+        list(GET URLS ${INDEX} URL)
+        list(GET PATHS ${INDEX} PATH)
+        list(GET HASHES ${INDEX} HASH)
+        downloader_fetch("${URL}" "${PATH}" "${HASH}" FAILURE_${INDEX})
+    endforeach()
+else()
+    # Workers are started at once as stages of a single pipeline,
+    # they claim entries from the queue shared through files
+    string(RANDOM LENGTH 8 QUEUE_SUFFIX)
+    set(QUEUE "${CMAKE_CURRENT_BINARY_DIR}/.downloader-${QUEUE_SUFFIX}")
+    string(REPLACE ";" "\n" URLS_CONTENT "${URLS}")
+    string(REPLACE ";" "\n" PATHS_CONTENT "${PATHS}")
+    string(REPLACE ";" "\n" HASHES_CONTENT "${HASHES}")
+    file(WRITE "${QUEUE}/urls" "${URLS_CONTENT}")
+    file(WRITE "${QUEUE}/paths" "${PATHS_CONTENT}")
+    file(WRITE "${QUEUE}/hashes" "${HASHES_CONTENT}")
+    file(WRITE "${QUEUE}/next" "0")
+
+    set(WORKER_OPTIONS "-DDOWNLOADER_QUEUE=${QUEUE}")
+    if (DEFINED DOWNLOADER_CACHE)
+        list(APPEND WORKER_OPTIONS "-DDOWNLOADER_CACHE=${DOWNLOADER_CACHE}")
+    endif()
+
+    set(WORKERS)
+    foreach(WORKER RANGE 1 ${DOWNLOADER_JOBS})
+        list(
+            APPEND
+            WORKERS
+                COMMAND
+                    "${CMAKE_COMMAND}"
+                    ${WORKER_OPTIONS}
+                    -P "${CMAKE_CURRENT_LIST_FILE}"
+            )
+    endforeach()
+
+    execute_process(
+        ${WORKERS}
+        RESULTS_VARIABLE WORKER_RESULTS
+        )
+
+    foreach(INDEX RANGE ${LAST_ENTRY})
+        if (EXISTS "${QUEUE}/status-${INDEX}")
+            file(READ "${QUEUE}/status-${INDEX}" FAILURE_${INDEX})
+        else()
+            set(
+                FAILURE_${INDEX}
+                "was not attempted, workers exited with ${WORKER_RESULTS}"
+                )
+        endif()
+    endforeach()
+
+    file(REMOVE_RECURSE "${QUEUE}")
+endif()
+
+set(FAILURES)
+foreach(INDEX RANGE ${LAST_ENTRY})
+    if (NOT "${FAILURE_${INDEX}}" STREQUAL "")
+        list(GET URLS ${INDEX} URL)
+        message("Downloading ${URL} ${FAILURE_${INDEX}}")
+        list(APPEND FAILURES ${INDEX})
+    endif()
+endforeach()
+
+list(LENGTH FAILURES NUMBER_OF_FAILURES)
+if (${NUMBER_OF_FAILURES} GREATER 0)
+    message(
+        FATAL_ERROR
+        "${NUMBER_OF_FAILURES} of ${NUMBER_OF_ENTRIES} downloads failed"
+        )
+endif()
@@ -0,0 +1,176 @@
+# Offline test of downloader.cmake with file:// URLs
+#
+# Options (should be passed before -P):
+#   -DDOWNLOADER=path       - path to downloader.cmake being tested
+#   -DWORKING_DIRECTORY=dir - directory for sources and downloads,
+#                             it is cleaned up before test
+
+cmake_minimum_required(VERSION 3.10)
+
+foreach(OPTION DOWNLOADER WORKING_DIRECTORY)
+    if (NOT DEFINED ${OPTION})
+        message(FATAL_ERROR "${OPTION} option is required")
+    endif()
+endforeach()
+
+file(REMOVE_RECURSE "${WORKING_DIRECTORY}")
+foreach(INDEX RANGE 1 6)
+    file(WRITE "${WORKING_DIRECTORY}/sources/file-${INDEX}" "content ${INDEX}\n")
+endforeach()
+set(SOURCES "file://${WORKING_DIRECTORY}/sources")
+foreach(INDEX RANGE 1 6)
+    file(SHA256 "${WORKING_DIRECTORY}/sources/file-${INDEX}" HASH_${INDEX})
+endforeach()
+
+# Runs downloader with JOBS and ARGN arguments and checks its exit code,
+# cache directory is used if CACHE_DIRECTORY variable is set
+function(downloader_test NAME JOBS EXPECTED_RESULT)
+    message("Test ${NAME}")
+    set(OPTIONS "-DDOWNLOADER_JOBS=${JOBS}")
+    if (DEFINED CACHE_DIRECTORY)
+        list(APPEND OPTIONS "-DDOWNLOADER_CACHE=${CACHE_DIRECTORY}")
+    endif()
+    execute_process(
+        COMMAND
+            "${CMAKE_COMMAND}"
+            ${OPTIONS}
+            -P "${DOWNLOADER}"
+            ${ARGN}
+        WORKING_DIRECTORY
+            "${WORKING_DIRECTORY}"
+        RESULT_VARIABLE RESULT
+        OUTPUT_QUIET
+        ERROR_QUIET
+        )
+    if (EXPECTED_RESULT AND RESULT EQUAL 0)
+        message(FATAL_ERROR "Test ${NAME} succeeded but should fail")
+    elseif (NOT EXPECTED_RESULT AND NOT RESULT EQUAL 0)
+        message(FATAL_ERROR "Test ${NAME} failed with ${RESULT}")
+    endif()
+endfunction()
+
+# Checks that file PATH is downloaded copy of source INDEX
+function(downloader_test_expect_copy PATH INDEX)
+    if (NOT EXISTS "${WORKING_DIRECTORY}/${PATH}")
+        message(FATAL_ERROR "${PATH} is not downloaded")
+    endif()
+    file(READ "${WORKING_DIRECTORY}/${PATH}" CONTENT)
+    if (NOT CONTENT STREQUAL "content ${INDEX}\n")
+        message(FATAL_ERROR "${PATH} has unexpected content: ${CONTENT}")
+    endif()
+endfunction()
+
+downloader_test(no_arguments 1 0)
+downloader_test(odd_arguments 1 1 "${SOURCES}/file-1")
+downloader_test(new_line_in_path 1 1 "${SOURCES}/file-1" "new\nline")
+downloader_test(bad_jobs 0 1 "${SOURCES}/file-1" sequential/file-1)
+
+downloader_test(
+    sequential 1 0
+    "${SOURCES}/file-1" sequential/file-1
+    "${SOURCES}/file-2" sequential/file-2
+    )
+downloader_test_expect_copy(sequential/file-1 1)
+downloader_test_expect_copy(sequential/file-2 2)
+
+# Destinations with spaces and non-ASCII characters are passed to workers
+set(CONCURRENT_ARGUMENTS)
+foreach(INDEX RANGE 1 6)
+    list(APPEND CONCURRENT_ARGUMENTS "${SOURCES}/file-${INDEX}" "concurrent/fïle ${INDEX}")
+endforeach()
+downloader_test(concurrent 3 0 ${CONCURRENT_ARGUMENTS})
+foreach(INDEX RANGE 1 6)
+    downloader_test_expect_copy("concurrent/fïle ${INDEX}" ${INDEX})
+endforeach()
+
+# More jobs than downloads
+downloader_test(excessive_jobs 16 0 "${SOURCES}/file-3" excessive/file-3)
+downloader_test_expect_copy(excessive/file-3 3)
+
+foreach(JOBS 1 2)
+    downloader_test(
+        missing_source_${JOBS} ${JOBS} 1
+        "${SOURCES}/file-1" missing-${JOBS}/file-1
+        "${SOURCES}/missing" missing-${JOBS}/missing
+        "${SOURCES}/file-2" missing-${JOBS}/file-2
+        )
+    # Failure of a single download does not stop others
+    downloader_test_expect_copy(missing-${JOBS}/file-1 1)
+    downloader_test_expect_copy(missing-${JOBS}/file-2 2)
+    if (EXISTS "${WORKING_DIRECTORY}/missing-${JOBS}/missing")
+        message(FATAL_ERROR "Partial file of failed download is left")
+    endif()
+endforeach()
+
+downloader_test(malformed_hash 1 1 "${SOURCES}/file-1" hashed/file-1 SHA256=1234)
+
+downloader_test(
+    bad_hash 1 1
+    "${SOURCES}/file-1" hashed/file-1 SHA256=${HASH_2}
+    )
+if (EXISTS "${WORKING_DIRECTORY}/hashed/file-1")
+    message(FATAL_ERROR "File with unexpected hash is left")
+endif()
+
+downloader_test(
+    hashed 1 0
+    "${SOURCES}/file-1" hashed/file-1 SHA256=${HASH_1}
+    "${SOURCES}/file-2" hashed/file-2
+    )
+downloader_test_expect_copy(hashed/file-1 1)
+downloader_test_expect_copy(hashed/file-2 2)
+
+# Sources are moved away to make sure files are not downloaded again
+file(RENAME "${WORKING_DIRECTORY}/sources" "${WORKING_DIRECTORY}/away")
+downloader_test(up_to_date 1 0 "${SOURCES}/file-1" hashed/file-1 SHA256=${HASH_1})
+file(RENAME "${WORKING_DIRECTORY}/away" "${WORKING_DIRECTORY}/sources")
+
+set(CACHE_DIRECTORY "${WORKING_DIRECTORY}/cache")
+set(CACHED_ARGUMENTS)
+foreach(INDEX RANGE 1 6)
+    list(
+        APPEND
+        CACHED_ARGUMENTS
+            "${SOURCES}/file-${INDEX}" cache-miss/file-${INDEX} SHA256=${HASH_${INDEX}}
+        )
+endforeach()
+downloader_test(cache_miss 3 0 ${CACHED_ARGUMENTS})
+foreach(INDEX RANGE 1 6)
+    downloader_test_expect_copy(cache-miss/file-${INDEX} ${INDEX})
+    downloader_test_expect_copy(cache/sha256/${HASH_${INDEX}} ${INDEX})
+endforeach()
+
+file(RENAME "${WORKING_DIRECTORY}/sources" "${WORKING_DIRECTORY}/away")
+string(REPLACE cache-miss cache-hit CACHED_ARGUMENTS "${CACHED_ARGUMENTS}")
+downloader_test(cache_hit 3 0 ${CACHED_ARGUMENTS})
+foreach(INDEX RANGE 1 6)
+    downloader_test_expect_copy(cache-hit/file-${INDEX} ${INDEX})
+endforeach()
+
+file(WRITE "${CACHE_DIRECTORY}/sha256/${HASH_1}" "corrupted\n")
+downloader_test(
+    corrupted_cache_without_source 1 1
+    "${SOURCES}/file-1" corrupted/file-1 SHA256=${HASH_1}
+    )
+if (EXISTS "${CACHE_DIRECTORY}/sha256/${HASH_1}")
+    message(FATAL_ERROR "Corrupted cache entry is left")
+endif()
+file(RENAME "${WORKING_DIRECTORY}/away" "${WORKING_DIRECTORY}/sources")
+
+file(WRITE "${CACHE_DIRECTORY}/sha256/${HASH_1}" "corrupted\n")
+downloader_test(
+    corrupted_cache 1 0
+    "${SOURCES}/file-1" corrupted/file-1 SHA256=${HASH_1}
+    )
+downloader_test_expect_copy(corrupted/file-1 1)
+downloader_test_expect_copy(cache/sha256/${HASH_1} 1)
+
+file(GLOB PARTS "${WORKING_DIRECTORY}/*/*.part-*" "${CACHE_DIRECTORY}/sha256/*.part-*")
+if (PARTS)
+    message(FATAL_ERROR "Temporary files are left: ${PARTS}")
+endif()
+
+file(GLOB QUEUES "${WORKING_DIRECTORY}/.downloader-*")
+if (QUEUES)
+    message(FATAL_ERROR "Queue directories are left: ${QUEUES}")
+endif()
@@ -0,0 +1,76 @@
+#!/usr/bin/env python3
+"""Local HTTP stand-in for remote hosts used by downloader tests.
+
+Serves "content of <path>" for every requested path after a delay and
+runs the given command with "{port}" substituted by the port listened on.
+Fails if the command fails or if number of simultaneous requests served
+was not between 2 and --jobs, so both sequential downloads and
+unbounded concurrency are caught.
+"""
+
+import argparse
+import http.server
+import subprocess
+import sys
+import threading
+import time
+
+
+class Handler(http.server.BaseHTTPRequestHandler):
+    lock = threading.Lock()
+    active = 0
+    peak = 0
+    delay = 0.0
+
+    def do_GET(self):
+        cls = type(self)
+        with cls.lock:
+            cls.active += 1
+            cls.peak = max(cls.peak, cls.active)
+        try:
+            time.sleep(cls.delay)
+            body = "content of {}\n".format(self.path).encode()
+            self.send_response(200)
+            self.send_header("Content-Length", str(len(body)))
+            self.end_headers()
+            self.wfile.write(body)
+        finally:
+            with cls.lock:
+                cls.active -= 1
+
+    def log_message(self, format, *args):
+        pass
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__)
+    parser.add_argument("--delay", type=float, default=0.5,
+                        help="seconds every response is delayed for")
+    parser.add_argument("--jobs", type=int, required=True,
+                        help="maximum expected simultaneous requests")
+    parser.add_argument("command", nargs="+",
+                        help="command to run, {port} is substituted")
+    arguments = parser.parse_args()
+
+    Handler.delay = arguments.delay
+    server = http.server.ThreadingHTTPServer(("127.0.0.1", 0), Handler)
+    port = str(server.server_address[1])
+    threading.Thread(target=server.serve_forever, daemon=True).start()
+
+    command = [part.replace("{port}", port) for part in arguments.command]
+    result = subprocess.call(command)
+    server.shutdown()
+
+    print("Peak of simultaneous requests: {}".format(Handler.peak))
+    if result != 0:
+        print("Command failed with {}".format(result))
+        return 1
+    if not 2 <= Handler.peak <= arguments.jobs:
+        print("Expected between 2 and {} simultaneous requests".format(
+            arguments.jobs))
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())